@@ -299,7 +299,7 @@ using namespace gpupixel;
     _faceReshapeFilter->SetFaceLandmarks(landmarks);
   }
 
-  _sourceRawData->ProcessData(pixels, stride, height, stride,
+  _sourceRawData->ProcessData(pixels, width, height, stride,
                               GPUPIXEL_FRAME_TYPE_BGRA);
 
   if (self.isSave) {
@@ -0,0 +1,108 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "gpupixel/face_detector/face_detector.h"
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+
+// A fixed pool of face detectors serving any number of streams. Models are
+// loaded once per worker instead of once per stream. Only the latest frame of
+// each stream is kept, a free worker takes the one that has waited longest
+// and delivers the landmarks to the stream's callback on its thread.
+// mars-face-kit detects one image per call, frames are not batched.
+class GPUPIXEL_API FaceDetectionService {
+ public:
+  struct Options {
+    FaceDetector::Options detector;
+    // Worker threads, each owning one detector instance, which bounds the
+    // frames detected concurrently
+    int num_workers = 1;
+  };
+
+  using LandmarksCallback = std::function<void(const std::vector<float>&)>;
+
+  // Shared instance, created on first use with the options of that call.
+  // Later calls return it as is.
+  static std::shared_ptr<FaceDetectionService> GetInstance();
+  static std::shared_ptr<FaceDetectionService> GetInstance(
+      const Options& options);
+  static std::shared_ptr<FaceDetectionService> Create(const Options& options);
+  ~FaceDetectionService();
+
+  // Returns a stream id used for Submit(). The callback is invoked on a
+  // worker thread with normalized landmarks, empty when no face was found,
+  // typically forwarded to the stream's filters as the "face_landmark"
+  // property.
+  int RegisterStream(LandmarksCallback callback);
+  void UnregisterStream(int stream_id);
+
+  // Queue a frame for detection, the data is copied so the caller may reuse
+  // it on return. A frame still pending for the same stream is replaced, so
+  // a slow service never builds up latency. Returns false for unknown
+  // streams.
+  bool Submit(int stream_id,
+              const uint8_t* data,
+              int width,
+              int height,
+              int stride,
+              GPUPIXEL_FRAME_TYPE type,
+              int rotation = 0);
+
+  struct Stats {
+    uint64_t frames_detected = 0;
+    uint64_t frames_dropped = 0;
+  };
+  Stats GetStats();
+
+ private:
+  FaceDetectionService(const Options& options);
+  void WorkerLoop(std::shared_ptr<FaceDetector> detector);
+
+  struct Frame {
+    std::vector<uint8_t> data;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    GPUPIXEL_FRAME_TYPE type = GPUPIXEL_FRAME_TYPE_RGBA;
+    int rotation = 0;
+  };
+
+  struct Stream {
+    LandmarksCallback callback;
+    Frame pending;
+    // Buffer recycled between submissions to avoid per-frame allocations
+    Frame spare;
+    bool has_pending = false;
+    bool in_flight = false;
+    std::chrono::steady_clock::time_point submit_time;
+  };
+
+  // Stream whose pending frame has waited longest, null when none is ready
+  std::shared_ptr<Stream> NextReadyStream() const;
+
+  Options options_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool running_ = true;
+  int next_stream_id_ = 1;
+  std::map<int, std::shared_ptr<Stream>> streams_;
+  std::vector<std::thread> workers_;
+  Stats stats_;
+};
+
+}  // namespace gpupixel
@@ -18,16 +18,78 @@ namespace gpupixel {
 
 class GPUPIXEL_API FaceDetector {
  public:
+  // mars-face-kit picks its own inference threads, backend and precision,
+  // only what is done around it can be configured
+  struct Options {
+    // Frames whose longer side exceeds this are downscaled before detection,
+    // 0 keeps the input size
+    int max_input_side = 0;
+    // Faces scoring below this are dropped
+    float score_threshold = 0.0f;
+    // Inferences run on a blank frame at creation to warm up the backend
+    int warm_up_runs = 0;
+  };
+
+  // Timing of the most recent Detect()/DetectYUV() call in milliseconds
+  struct Latency {
+    double preprocess_ms = 0;
+    double inference_ms = 0;
+    double total_ms = 0;
+    int face_count = 0;
+  };
+
   static std::shared_ptr<FaceDetector> Create();
+  static std::shared_ptr<FaceDetector> Create(const Options& options);
+
+  // |stride| is the row pitch in bytes of the first plane. For YUV frame types
+  // the chroma plane(s) must follow the luma plane contiguously; use
+  // DetectYUV() for frames with separate plane pointers. |rotation| is the
+  // clockwise rotation (0, 90, 180, 270) that makes the frame upright, the
+  // returned landmarks are normalized to the upright frame.
+  // GPUPIXEL_MODE_FMT_VIDEO frames are downscaled to Options::max_input_side
+  // and carry their capture time, GPUPIXEL_MODE_FMT_PICTURE ones are
+  // detected at full size as unrelated stills.
   std::vector<float> Detect(const uint8_t* data,
                             int width,
                             int height,
                             int stride,
                             GPUPIXEL_MODE_FMT fmt,
-                            GPUPIXEL_FRAME_TYPE type);
+                            GPUPIXEL_FRAME_TYPE type,
+                            int rotation = 0);
+
+  // Detect directly on planar (I420) or semi-planar (NV12/NV21) frames without
+  // a colour conversion. For NV12/NV21 |data_u| is the interleaved chroma
+  // plane and |data_v| is ignored. Planes that are not laid out contiguously
+  // are detected on luma only.
+  std::vector<float> DetectYUV(const uint8_t* data_y,
+                               int stride_y,
+                               const uint8_t* data_u,
+                               int stride_u,
+                               const uint8_t* data_v,
+                               int stride_v,
+                               int width,
+                               int height,
+                               GPUPIXEL_MODE_FMT fmt,
+                               GPUPIXEL_FRAME_TYPE type,
+                               int rotation = 0);
+
+  const Options& GetOptions() const { return options_; }
+  const Latency& GetLastLatency() const { return last_latency_; }
 
  private:
-  FaceDetector();
+  FaceDetector(const Options& options);
+  void WarmUp();
+  std::vector<float> DetectImage(const uint8_t* data,
+                                 int width,
+                                 int height,
+                                 int width_step,
+                                 int pixel_format,
+                                 GPUPIXEL_MODE_FMT fmt,
+                                 int rotation);
+
   std::shared_ptr<mars_face_kit::MarsFaceDetector> mars_face_detector_;
+  Options options_;
+  Latency last_latency_;
+  std::vector<uint8_t> scale_buffer_;
 };
 }  // namespace gpupixel
@@ -24,20 +24,23 @@ class GPUPIXEL_API BeautyFaceFilter : public FilterGroup {
 
   void SetHighPassDelta(float highPassDelta);
   void SetSharpen(float sharpen);
+  // Staged like SetProperty(), safe from any thread
   void SetBlurAlpha(float blurAlpha);
   void SetWhite(float white);
   void SetRadius(float sigma);
-
-  virtual void SetInputFramebuffer(
-      std::shared_ptr<GPUPixelFramebuffer> framebuffer,
-      RotationMode rotation_mode = NoRotation,
-      int texIdx = 0) override;
+  // SEPARABLE keeps the box blur for the mean image
+  void SetBlurEngine(GaussianBlurFilter::BlurEngine engine);
 
  private:
   BeautyFaceFilter();
   std::shared_ptr<BoxBlurFilter> box_blur_filter_;
+  std::shared_ptr<DualKawaseBlurFilter> pyramid_blur_filter_;
+  GaussianBlurFilter::BlurEngine engine_ = GaussianBlurFilter::SEPARABLE;
+  float radius_ = 4;
   std::shared_ptr<BoxHighPassFilter> box_high_pass_filter_;
   std::shared_ptr<BeautyFaceUnitFilter> beauty_face_filter_;
+  PropertyHandle whiteness_property_ = kInvalidPropertyHandle;
+  PropertyHandle skin_smoothing_property_ = kInvalidPropertyHandle;
 };
 
 }  // namespace gpupixel
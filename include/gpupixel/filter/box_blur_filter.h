@@ -22,6 +22,7 @@ class GPUPIXEL_API BoxBlurFilter : public FilterGroup {
   void SetRadius(int radius);
   void setSigma(float sigma);
   void SetTexelSpacingMultiplier(float value);
+  std::string GetFingerprint() const override;
 
  protected:
   BoxBlurFilter();
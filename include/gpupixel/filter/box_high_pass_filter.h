@@ -22,11 +22,6 @@ class GPUPIXEL_API BoxHighPassFilter : public FilterGroup {
   void SetRadius(float radius);
   void SetDelta(float delta);
 
-  virtual void SetInputFramebuffer(
-      std::shared_ptr<GPUPixelFramebuffer> framebuffer,
-      RotationMode rotation_mode /* = NoRotation*/,
-      int texIdx /* = 0*/) override;
-
  protected:
   BoxHighPassFilter();
 
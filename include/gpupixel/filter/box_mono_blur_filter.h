@@ -10,6 +10,7 @@
 #include "gpupixel/gpupixel_define.h"
 
 #include "gpupixel/filter/gaussian_blur_mono_filter.h"
+#include "gpupixel/utils/math_toolbox.h"
 
 namespace gpupixel {
 class GPUPIXEL_API BoxMonoBlurFilter : public GaussianBlurMonoFilter {
@@ -21,13 +22,41 @@ class GPUPIXEL_API BoxMonoBlurFilter : public GaussianBlurMonoFilter {
   bool Init(int radius, float sigma);
   void SetRadius(int radius);
 
+  bool DoRender(bool updateSinks = true) override;
+
+  // Up to this radius a single pass reading every tap is cheapest; beyond it
+  // the box is built by recursive doubling in O(log radius) passes of two
+  // taps each, with no upper limit on the radius. The passes ping-pong
+  // between four full size framebuffers, RGBA16F where renderable, kept for
+  // the filter's lifetime. Contexts with compute shaders take the same
+  // path, there is no summed-area table variant.
+  static constexpr int kMaxSinglePassRadius = 14;
+
  protected:
   BoxMonoBlurFilter(Type type);
 
+  bool RenderRecursiveDoubling(bool updateSinks);
+  void RenderDoublingPass(std::shared_ptr<GPUPixelFramebuffer> target,
+                          std::shared_ptr<GPUPixelFramebuffer> first,
+                          RotationMode first_rotation,
+                          std::shared_ptr<GPUPixelFramebuffer> second,
+                          RotationMode second_rotation,
+                          Vector2 second_offset,
+                          float weight);
+  Vector2 GetAxisStep(RotationMode rotation) const;
+
+  // Box taps are baked into the shader, rebuild it for the exact radius
+  void UpdateBlurProgram() override;
+
   std::string GenerateOptimizedVertexShaderString(int radius,
                                                   float sigma) override;
   std::string GenerateOptimizedFragmentShaderString(int radius,
                                                     float sigma) override;
+
+  GPUPixelGLProgram* doubling_program_ = nullptr;
+  uint32_t doubling_position_attribute_ = 0;
+  // Ping-pong targets for the doubled and the accumulated box
+  std::shared_ptr<GPUPixelFramebuffer> doubling_framebuffers_[4];
 };
 
 }  // namespace gpupixel
@@ -16,6 +16,7 @@ class GPUPIXEL_API BrightnessFilter : public Filter {
   static std::shared_ptr<BrightnessFilter> Create(float brightness = 0.0);
   bool Init(float brightness);
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setBrightness(float brightness);
 
@@ -12,6 +12,7 @@
 #include "gpupixel/filter/filter_group.h"
 #include "gpupixel/filter/grayscale_filter.h"
 #include "gpupixel/filter/single_component_gaussian_blur_filter.h"
+#include "gpupixel/filter/stencil_chain_filter.h"
 #include "gpupixel/filter/weak_pixel_inclusion_filter.h"
 #include "gpupixel/gpupixel_define.h"
 
@@ -25,6 +26,9 @@ class GPUPIXEL_API CannyEdgeDetectionFilter : public FilterGroup {
  protected:
   CannyEdgeDetectionFilter();
 
+  // All stages in one dispatch when compute shaders are available, the
+  // filters below are only created otherwise
+  std::shared_ptr<StencilChainFilter> fused_filter_;
   std::shared_ptr<GrayscaleFilter> grayscale_filter_;
   std::shared_ptr<SingleComponentGaussianBlurFilter> blur_filter_;
   std::shared_ptr<DirectionalSobelEdgeDetectionFilter> edge_detection_filter_;
@@ -17,6 +17,7 @@ class GPUPIXEL_API ColorInvertFilter : public Filter {
   bool Init();
 
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
  protected:
   ColorInvertFilter() {};
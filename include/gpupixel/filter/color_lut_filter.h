@@ -0,0 +1,56 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <vector>
+#include "gpupixel/filter/filter.h"
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+
+// Applies a chain of per-pixel colour filters (ColorMatrixFilter, HSBFilter,
+// HueFilter, ContrastFilter, ExposureFilter, ...) with a single lookup per
+// pixel, whatever the chain's length.
+//
+// The chain is evaluated on the GPU over a 64x64x64 colour lattice, stored
+// as the usual 512x512 image of 8x8 tiles, and the result is cached by the
+// chain's fingerprints. Parameters are compared on every frame; the lattice is
+// only baked again, or taken from the cache, when one of them changed.
+//
+// The chain's filters only hold parameters, they must not be connected to
+// any graph. Every filter must provide a fingerprint, which is how pure colour
+// filters are recognized. The input's alpha is passed through.
+class GPUPIXEL_API ColorLutFilter : public Filter {
+ public:
+  static std::shared_ptr<ColorLutFilter> Create(
+      const std::vector<std::shared_ptr<Filter>>& chain);
+  ~ColorLutFilter();
+  bool Init(const std::vector<std::shared_ptr<Filter>>& chain);
+
+  virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
+
+  static constexpr int kLatticeSize = 64;
+  static constexpr int kLutImageSize = 512;
+
+ protected:
+  ColorLutFilter();
+
+ private:
+  std::string GetChainFingerprint() const;
+  void UpdateLut();
+  std::shared_ptr<GPUPixelFramebuffer> BakeLut();
+
+  std::vector<std::shared_ptr<Filter>> chain_;
+  GPUPixelGLProgram* identity_program_ = nullptr;
+  std::shared_ptr<GPUPixelFramebuffer> identity_framebuffer_;
+  std::shared_ptr<GPUPixelFramebuffer> lut_framebuffer_;
+  std::string lut_key_;
+};
+
+}  // namespace gpupixel
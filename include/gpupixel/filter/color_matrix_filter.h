@@ -17,6 +17,7 @@ class GPUPIXEL_API ColorMatrixFilter : public Filter {
   bool Init();
 
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setIntensity(float intensity) { intensity_factor_ = intensity; }
   void setColorMatrix(Matrix4 color_matrix) { color_matrix_ = color_matrix; }
@@ -0,0 +1,61 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include "gpupixel/filter/filter.h"
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+
+// Filter that runs a compute shader over its output image when the context
+// supports it and its fragment shader otherwise. Both variants live in the
+// same graph node, so sinks, sources and properties behave exactly as for
+// Filter. Subclasses set their uniforms on filter_program_ before calling
+// ComputeFilter::DoRender(), whichever program it holds.
+//
+// The compute source is the shader body. A header is prepended that
+// declares, with one invocation per output pixel:
+//   layout(local_size_x = kWorkGroupSize, local_size_y = kWorkGroupSize)
+//   writeonly image2D outputImage      - the filter's framebuffer
+//   sampler2D inputImageTexture[N]     - named as in fragment filters
+//   vec2 textureCoordinateAt(ivec2)    - input coordinate of an output pixel,
+//                                        including the input rotation
+// and WORK_GROUP_SIZE for sizing shared memory tiles.
+//
+// The output image is declared without a format qualifier and bound in the
+// framebuffer's format, so SetOutputFormat() applies to both variants.
+//
+// An empty fragment source means there is no fallback, Create() then returns
+// null when compute shaders are unavailable.
+class GPUPIXEL_API ComputeFilter : public Filter {
+ public:
+  static std::shared_ptr<ComputeFilter> Create(
+      const std::string& compute_shader_source,
+      const std::string& fragment_shader_source,
+      int input_number = 1);
+  ~ComputeFilter();
+
+  bool InitWithComputeShaderString(const std::string& compute_shader_source,
+                                   const std::string& fragment_shader_source,
+                                   int input_number = 1);
+
+  virtual bool DoRender(bool update_sinks = true) override;
+
+  bool IsUsingCompute() const { return using_compute_; }
+
+  static constexpr int kWorkGroupSize = 16;
+
+ protected:
+  ComputeFilter();
+
+  std::string GetComputeShaderHeader(int input_number) const;
+
+  bool using_compute_ = false;
+};
+
+}  // namespace gpupixel
@@ -16,6 +16,7 @@ class GPUPIXEL_API ContrastFilter : public Filter {
   static std::shared_ptr<ContrastFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setContrast(float contrast);
 
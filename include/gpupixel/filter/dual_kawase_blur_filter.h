@@ -0,0 +1,51 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <vector>
+#include "gpupixel/filter/filter_group.h"
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+class DualKawaseSampleFilter;
+
+// Pyramid blur: the input is halved through a chain of framebuffers and then
+// upsampled back with tent filters. Each level costs a fixed number of taps
+// on a quarter of the previous pixels, so large radii cost about the same as
+// small ones. The result approximates a Gaussian of the given radius.
+class GPUPIXEL_API DualKawaseBlurFilter : public FilterGroup {
+ public:
+  static std::shared_ptr<DualKawaseBlurFilter> Create(int radius = 16);
+  ~DualKawaseBlurFilter();
+  bool Init(int radius);
+
+  void SetRadius(int radius);
+  int GetRadius() const { return radius_; }
+  std::string GetFingerprint() const override;
+
+  virtual void SetInputFramebuffer(
+      std::shared_ptr<GPUPixelFramebuffer> framebuffer,
+      RotationMode rotation_mode = NoRotation,
+      int texIdx = 0) override;
+
+  static constexpr int kMaxIterations = 8;
+
+ protected:
+  DualKawaseBlurFilter();
+
+ private:
+  void UpdateChain();
+
+  int radius_ = 0;
+  int iterations_ = 0;
+  float offset_ = 1.0;
+  std::vector<std::shared_ptr<DualKawaseSampleFilter>> down_filters_;
+  std::vector<std::shared_ptr<DualKawaseSampleFilter>> up_filters_;
+};
+
+}  // namespace gpupixel
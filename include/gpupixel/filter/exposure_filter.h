@@ -15,6 +15,7 @@ class GPUPIXEL_API ExposureFilter : public Filter {
   static std::shared_ptr<ExposureFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void SetExposure(float exposure);
 
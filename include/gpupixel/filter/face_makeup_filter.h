@@ -26,7 +26,8 @@ class GPUPIXEL_API FaceMakeupFilter : public Filter {
   virtual bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
 
-  inline void SetBlendLevel(float level) { this->blend_level_ = level; }
+  // Staged like SetProperty(), safe from any thread
+  void SetBlendLevel(float level);
   void SetFaceLandmarks(std::vector<float> landmarks);
 
  protected:
@@ -42,6 +43,8 @@ class GPUPIXEL_API FaceMakeupFilter : public Filter {
   std::vector<float> face_landmarks_;
   float blend_level_ = 0;  //[0. 0.5]
   bool has_face_ = false;
+  PropertyHandle blend_level_property_ = kInvalidPropertyHandle;
+  PropertyHandle face_landmark_property_ = kInvalidPropertyHandle;
   //
   GPUPixelGLProgram* filter_program2_ = nullptr;
   uint32_t filter_position_attribute2_ = 0;
@@ -19,6 +19,7 @@ class GPUPIXEL_API FaceReshapeFilter : public Filter {
   bool Init();
   bool DoRender(bool updateSinks = true) override;
 
+  // Staged like SetProperty(), safe from any thread
   void SetFaceSlimLevel(float level);
   void SetEyeZoomLevel(float level);
   void SetFaceLandmarks(std::vector<float> landmarks);
@@ -29,6 +30,10 @@ class GPUPIXEL_API FaceReshapeFilter : public Filter {
 
   std::vector<float> face_landmarks_;
   int has_face_ = 0;
+
+  PropertyHandle thin_face_property_ = kInvalidPropertyHandle;
+  PropertyHandle big_eye_property_ = kInvalidPropertyHandle;
+  PropertyHandle face_landmark_property_ = kInvalidPropertyHandle;
 };
 
 }  // namespace gpupixel
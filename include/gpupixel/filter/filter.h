@@ -11,7 +11,10 @@
 #include "gpupixel/sink/sink.h"
 #include "gpupixel/source/source.h"
 #include "gpupixel/utils/math_toolbox.h"
+#include "gpupixel/utils/triple_buffer.h"
 
+#include <atomic>
+#include <future>
 #include <string>
 #include <vector>
 namespace gpupixel {
@@ -48,6 +51,13 @@ class GPUPIXEL_API Filter : public Source, public Sink {
 
   static std::shared_ptr<Filter> Create(const std::string& filter_class_name);
 
+  // Compiles the programs of the named filters on the GL thread, one task
+  // per filter, without blocking the caller. Filters created afterwards take
+  // them over instead of compiling, a name listed twice warms two instances.
+  // The future is false if a name is unknown.
+  static std::future<bool> WarmUp(
+      const std::vector<std::string>& filter_class_names);
+
   static std::shared_ptr<Filter> CreateWithShaderString(
       const std::string& vertex_shader_source,
       const std::string& fragment_shader_source);
@@ -73,9 +83,32 @@ class GPUPIXEL_API Filter : public Source, public Sink {
 
   virtual bool DoRender(bool update_sinks = true) override;
 
+  bool RendersPrepareFrames() const override { return true; }
+
   GPUPixelGLProgram* GetGlProgram() const { return filter_program_; };
 
+  // Identifies everything that determines this filter's output for a given
+  // input. Two filters of one group with equal, non-empty fingerprints are
+  // merged by FilterGroup::Finalize(). Empty by default, filters opt in by
+  // covering all of their state.
+  virtual std::string GetFingerprint() const { return ""; }
+
+  // Texel format of the framebuffer Render() creates. Monochrome stages use
+  // R8 to move a quarter of the bytes, samplers downstream read it as grey.
+  void SetOutputFormat(GPUPIXEL_FRAMEBUFFER_FORMAT format) {
+    output_format_ = format;
+  }
+  GPUPIXEL_FRAMEBUFFER_FORMAT GetOutputFormat() const { return output_format_; }
+
   // property setters & getters
+  //
+  // Values set on any thread are staged and applied on the GL thread at the
+  // start of the next Render(), where the property's callback runs. Setting
+  // never blocks on rendering. A property takes values from one thread at a
+  // time, and GetProperty() returns the last value set on that thread.
+  using PropertyHandle = int;
+  static constexpr PropertyHandle kInvalidPropertyHandle = -1;
+
   bool RegisterProperty(const std::string& name,
                         int default_value,
                         const std::string& comment = "",
@@ -120,9 +153,32 @@ class GPUPIXEL_API Filter : public Source, public Sink {
 
   bool GetPropertyType(const std::string& name, std::string& ret_type);
 
+  // Resolves a name once for setters called every frame, valid for the
+  // filter's lifetime
+  PropertyHandle GetPropertyHandle(const std::string& name) const;
+
+  bool SetProperty(PropertyHandle handle, int value);
+
+  bool SetProperty(PropertyHandle handle, float value);
+
+  bool SetProperty(PropertyHandle handle, const std::vector<float>& value);
+
+  bool SetProperty(PropertyHandle handle, const std::string& value);
+
+  // Applies the values staged since the last frame, on the GL thread.
+  // Render() does it, filters that don't render, e.g. merged ones or those
+  // only holding parameters, get it before their fingerprint is read.
+  virtual void ApplyPendingProperties();
+
  protected:
+  // Size of the framebuffer Render() creates, the rotated first input scaled
+  // by framebuffer_scale_ by default. False skips the frame.
+  virtual bool GetOutputSize(int& width, int& height) const;
+
   GPUPixelGLProgram* filter_program_;
   uint32_t filter_position_attribute_;
+  GPUPIXEL_FRAMEBUFFER_FORMAT output_format_ =
+      GPUPIXEL_FRAMEBUFFER_FORMAT_RGBA8;
   std::string filter_class_name_;
   struct {
     float r;
@@ -139,37 +195,68 @@ class GPUPIXEL_API Filter : public Source, public Sink {
 
   // properties
   struct Property {
+    virtual ~Property() {}
+    // Takes the staged value, if any, and runs the callback with it
+    virtual void ApplyPending() = 0;
+
     std::string type;
     std::string comment;
+    PropertyHandle handle = kInvalidPropertyHandle;
   };
 
   Property* GetProperty(const std::string& name);
-
-  struct IntProperty : Property {
-    int value;
-    std::function<void(int&)> on_property_set_func;
+  Property* GetProperty(PropertyHandle handle);
+
+  template <typename T>
+  struct TypedProperty : Property {
+    void ApplyPending() override {
+      if (!staged.Read(pending)) {
+        return;
+      }
+      if (on_property_set_func) {
+        on_property_set_func(pending);
+      }
+      value = pending;
+    }
+
+    // As last applied on the GL thread
+    T value;
+    TripleBuffer<T> staged;
+    T pending;
+    std::function<void(T&)> on_property_set_func;
   };
+
+  using IntProperty = TypedProperty<int>;
   std::map<std::string, IntProperty> int_properties_;
 
-  struct FloatProperty : Property {
-    float value;
-    std::function<void(float&)> on_property_set_func;
-  };
+  using FloatProperty = TypedProperty<float>;
   std::map<std::string, FloatProperty> float_properties_;
 
-  struct VectorProperty : Property {
-    std::vector<float> value;
-    std::function<void(std::vector<float>&)> on_property_set_func;
-  };
+  using VectorProperty = TypedProperty<std::vector<float>>;
   std::map<std::string, VectorProperty> vector_properties_;
 
-  struct StringProperty : Property {
-    std::string value;
-    std::function<void(std::string&)> on_property_set_func;
-  };
+  using StringProperty = TypedProperty<std::string>;
   std::map<std::string, StringProperty> string_properties_;
 
+  // Indexed by handle, the nodes of the maps above don't move
+  std::vector<Property*> property_handles_;
+  std::atomic<bool> has_pending_properties_{false};
+
  private:
+  template <typename T>
+  bool RegisterTypedProperty(
+      std::map<std::string, TypedProperty<T>>& properties,
+      const std::string& name,
+      const std::string& type,
+      const T& default_value,
+      const std::string& comment,
+      std::function<void(T&)> on_property_set_func);
+
+  template <typename T>
+  bool StageProperty(Property* property,
+                     const std::string& type,
+                     const T& value);
+
   static std::map<std::string, std::function<std::shared_ptr<Filter>()>>
       filter_factories_;
 };
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 #include "gpupixel/filter/filter.h"
 #include "gpupixel/gpupixel_define.h"
@@ -33,8 +35,20 @@ class GPUPIXEL_API FilterGroup : public Filter {
   // sequence Most often, it's not necessary to specify the terminal filter
   // manually, as the terminal filter will be specified automatically.
   void SetTerminalFilter(std::shared_ptr<Filter> filter) {
-    terminal_filter_ = filter;
+    std::atomic_store(&terminal_filter_, filter);
   }
+  std::shared_ptr<Filter> GetTerminalFilter() const {
+    return std::atomic_load(&terminal_filter_);
+  }
+
+  // Entry filters, including those of nested groups, all read the group's
+  // input. Those with equal fingerprints compute the same output, so only
+  // the first one is kept and the sinks of the others are moved onto it.
+  // Runs on the first Render(); a merge is undone on the next input once the
+  // fingerprints diverge, and the next Render() tries again.
+  void Finalize();
+  // One line per merged filter, as of the last Finalize()
+  std::vector<std::string> GetMergeReport() const;
 
   virtual std::shared_ptr<Source> AddSink(std::shared_ptr<Sink> sink) override;
   virtual std::shared_ptr<Source> AddSink(std::shared_ptr<Sink> sink,
@@ -42,7 +56,7 @@ class GPUPIXEL_API FilterGroup : public Filter {
   virtual void RemoveSink(std::shared_ptr<Sink> sink) override;
   virtual void RemoveAllSinks() override;
   virtual bool HasSink(const std::shared_ptr<Sink> sink) const override;
-  virtual std::map<std::shared_ptr<Sink>, int>& GetSinks() override;
+  virtual std::shared_ptr<const SinkMap> GetSinks() const override;
   virtual bool DoRender(bool updateSinks = true) override;
   virtual void Render() override;
   virtual void DoUpdateSinks() override;
@@ -58,14 +72,53 @@ class GPUPIXEL_API FilterGroup : public Filter {
 
   virtual bool IsReady() const override;
   virtual void ResetAndClean() override;
+  // Its own and its members', whose values make up its fingerprint
+  void ApplyPendingProperties() override;
 
  protected:
-  std::vector<std::shared_ptr<Filter>> filters_;
-  std::shared_ptr<Filter> terminal_filter_;
-
   FilterGroup();
   static std::shared_ptr<Filter> PredictTerminalFilter(
       std::shared_ptr<Filter> filter);
+  // The members live in the graph's snapshot, so the render thread reads
+  // them without a lock. Replacing them is an edit like any other.
+  std::vector<std::shared_ptr<Filter>> GetFilters() const;
+  void SetFilters(std::vector<std::shared_ptr<Filter>> filters);
+
+ private:
+  struct EntryFilter {
+    // Nested group owning |filter|, null for this group
+    std::shared_ptr<FilterGroup> owner;
+    std::shared_ptr<Filter> filter;
+  };
+  struct MergedFilter {
+    std::shared_ptr<FilterGroup> owner;
+    std::shared_ptr<Filter> filter;
+    std::shared_ptr<Filter> replacement;
+    std::map<std::shared_ptr<Sink>, int> sinks;
+    std::string report;
+  };
+
+  // Fingerprint with what else shapes the output, e.g. format and scale.
+  // Empty when the filter doesn't take part in merging.
+  static std::string GetMergeKey(const Filter& filter);
+  // Edits relative to the snapshot they are replayed on
+  void AppendFilter(std::shared_ptr<Filter> filter);
+  void EraseFilter(std::shared_ptr<Filter> filter);
+  void CollectEntryFilters(std::shared_ptr<FilterGroup> self,
+                           std::vector<EntryFilter>& entries);
+  // Restores merged filters, all of them or, on the GL thread, those whose
+  // fingerprint no longer matches their replacement's
+  void UndoMerges(bool diverged_only);
+
+  // Read and written by several threads, use the accessors
+  std::shared_ptr<Filter> terminal_filter_;
+  // Cleared by edits on any thread, set by Finalize()
+  std::atomic<bool> finalized_{false};
+  // Held while the merges are changed, which only edits the graph, so that
+  // removing filters on another thread never waits for a frame
+  mutable std::mutex merge_mutex_;
+  std::vector<MergedFilter> merged_filters_;
+  std::vector<std::string> merge_report_;
 };
 
 }  // namespace gpupixel
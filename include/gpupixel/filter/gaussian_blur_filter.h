@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "gpupixel/filter/dual_kawase_blur_filter.h"
 #include "gpupixel/filter/filter_group.h"
 #include "gpupixel/filter/gaussian_blur_mono_filter.h"
 #include "gpupixel/gpupixel_define.h"
@@ -14,6 +15,10 @@
 namespace gpupixel {
 class GPUPIXEL_API GaussianBlurFilter : public FilterGroup {
  public:
+  // SEPARABLE runs two full resolution passes whose cost grows with the
+  // radius, PYRAMID trades exactness for a near constant cost at large radii
+  enum BlurEngine { SEPARABLE, PYRAMID };
+
   virtual ~GaussianBlurFilter();
 
   static std::shared_ptr<GaussianBlurFilter> Create(int radius = 4,
@@ -21,6 +26,8 @@ class GPUPIXEL_API GaussianBlurFilter : public FilterGroup {
   bool Init(int radius, float sigma);
   void SetRadius(int radius);
   void setSigma(float sigma);
+  void SetBlurEngine(BlurEngine engine);
+  std::string GetFingerprint() const override;
 
  protected:
   GaussianBlurFilter();
@@ -28,6 +35,10 @@ class GPUPIXEL_API GaussianBlurFilter : public FilterGroup {
  private:
   std::shared_ptr<GaussianBlurMonoFilter> horizontal_blur_filter_;
   std::shared_ptr<GaussianBlurMonoFilter> vertical_blur_filter_;
+  std::shared_ptr<DualKawaseBlurFilter> pyramid_blur_filter_;
+  BlurEngine engine_ = SEPARABLE;
+  // As last set, the members apply theirs with the next frame
+  int radius_ = 4;
 };
 
 }  // namespace gpupixel
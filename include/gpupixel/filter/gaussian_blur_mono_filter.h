@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <vector>
 #include "gpupixel/filter/filter_group.h"
 #include "gpupixel/gpupixel_define.h"
 
@@ -18,13 +21,21 @@ class GPUPIXEL_API GaussianBlurMonoFilter : public Filter {
   static std::shared_ptr<GaussianBlurMonoFilter> Create(Type type = HORIZONTAL,
                                                         int radius = 4,
                                                         float sigma = 2.0);
+  ~GaussianBlurMonoFilter();
   bool Init(int radius, float sigma);
 
+  // Staged, the program and taps are updated on the GL thread before the
+  // next frame. The radius is clamped to kMaxRadius.
   void SetRadius(int radius);
   void setSigma(float sigma);
+  // As last applied on the GL thread
+  int GetRadius() const { return radius_; }
+  // Radius setSigma() picks, the outermost tap weighs about 1/256
+  static int RadiusForSigma(float sigma);
 
   virtual bool DoRender(bool updateSinks = true) override;
   void SetTexelSpacingMultiplier(float value);
+  std::string GetFingerprint() const override;
 
  protected:
   GaussianBlurMonoFilter(Type type = HORIZONTAL);
@@ -35,14 +46,38 @@ class GPUPIXEL_API GaussianBlurMonoFilter : public Filter {
   float vertical_texel_spacing_ = 1.0;
   float horizontal_texel_spacing_ = 1.0;
 
+  // Radius is clamped to this with a warning, larger blurs should downscale
+  // first
+  static constexpr int kMaxRadius = 64;
+
+  // Called whenever radius or sigma changes. Selects the program of the
+  // radius bucket and recomputes the tap uniforms, no shader is compiled
+  // unless no live blur filter has used the bucket yet.
+  virtual void UpdateBlurProgram();
+
   virtual std::string GenerateOptimizedVertexShaderString(int radius,
                                                           float sigma);
   virtual std::string GenerateOptimizedFragmentShaderString(int radius,
                                                             float sigma);
+  // Fragment shader reading |pair_count| linear-sampled tap pairs on each
+  // side from the blurTaps uniform array
+  std::string GenerateBucketFragmentShaderString(int pair_count,
+                                                 bool single_component) const;
+  // Radius buckets hold 2, 4, 8, 16 or 32 tap pairs
+  static int PairCountForRadius(int radius);
 
  private:
-  virtual std::string GenerateVertexShaderString(int radius, float sigma);
-  virtual std::string GenerateFragmentShaderString(int radius, float sigma);
+  // GL thread, from the staged properties
+  void ApplyRadius(int radius);
+  void ApplySigma(float sigma);
+  void UpdateBlurWeights(int pair_count);
+
+  // Bucket pair count -> program, built lazily and shared with the other
+  // blur filters of the same shader sources
+  std::map<int, std::shared_ptr<GPUPixelGLProgram>> bucket_programs_;
+  float center_weight_ = 1.0;
+  // (offset, weight) of two tap pairs per vec4
+  std::vector<float> blur_taps_;
 };
 
 }  // namespace gpupixel
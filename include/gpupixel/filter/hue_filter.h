@@ -16,6 +16,7 @@ class GPUPIXEL_API HueFilter : public Filter {
   static std::shared_ptr<HueFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setHueAdjustment(float hue_adjustment);
 
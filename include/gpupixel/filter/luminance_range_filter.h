@@ -16,6 +16,7 @@ class GPUPIXEL_API LuminanceRangeFilter : public Filter {
   static std::shared_ptr<LuminanceRangeFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setRangeReductionFactor(float range_reduction_factor);
 
@@ -16,6 +16,7 @@ class GPUPIXEL_API PosterizeFilter : public Filter {
   static std::shared_ptr<PosterizeFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setColorLevels(int color_levels);
 
@@ -16,6 +16,7 @@ class GPUPIXEL_API RGBFilter : public Filter {
   static std::shared_ptr<RGBFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setRedAdjustment(float red_adjustment);
   void setGreenAdjustment(float green_adjustment);
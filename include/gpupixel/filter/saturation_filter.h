@@ -16,6 +16,7 @@ class GPUPIXEL_API SaturationFilter : public Filter {
   static std::shared_ptr<SaturationFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setSaturation(float saturation);
 
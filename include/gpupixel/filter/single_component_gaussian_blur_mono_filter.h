@@ -21,8 +21,6 @@ class GPUPIXEL_API SingleComponentGaussianBlurMonoFilter
   SingleComponentGaussianBlurMonoFilter(Type type = HORIZONTAL);
 
  private:
-  std::string GenerateOptimizedVertexShaderString(int radius,
-                                                  float sigma) override;
   std::string GenerateOptimizedFragmentShaderString(int radius,
                                                     float sigma) override;
 };
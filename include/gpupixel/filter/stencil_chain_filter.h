@@ -0,0 +1,56 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <vector>
+#include "gpupixel/filter/compute_filter.h"
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+
+// Runs a chain of neighbourhood stages in a single compute dispatch. Each
+// work group loads its tile plus the halo needed by all stages into shared
+// memory once, then applies the stages back to back on shrinking regions of
+// that tile, so intermediate results never go through a framebuffer.
+//
+// A stage is the body of a function returning the stage's vec4 value for
+// `ivec2 pixel`. It reads the previous stage, or the input image for the
+// first stage, with sampleInput(ivec2 offset), offsets being limited to the
+// stage's radius. Reads beyond the image edge are clamped, and each result is
+// clamped to [0, 1], as the equivalent chain of 8-bit framebuffers would do.
+//
+// There is no fragment fallback: Create() returns null when compute shaders
+// are not available, callers build the multi-pass chain instead.
+class GPUPIXEL_API StencilChainFilter : public ComputeFilter {
+ public:
+  struct Stage {
+    std::string source;
+    int radius_x = 1;
+    int radius_y = 1;
+  };
+
+  // |declarations| is shared GLSL placed before the stages, e.g. uniforms
+  static std::shared_ptr<StencilChainFilter> Create(
+      const std::vector<Stage>& stages,
+      const std::string& declarations = "");
+  ~StencilChainFilter();
+
+  bool Init(const std::vector<Stage>& stages, const std::string& declarations);
+
+  // Halo plus tile must fit two vec4 tiles into the 32KB of shared memory
+  // every GL 4.3 implementation provides
+  static constexpr int kMaxHalo = 8;
+
+ protected:
+  StencilChainFilter();
+
+  std::string GenerateComputeShaderString(const std::vector<Stage>& stages,
+                                          const std::string& declarations);
+};
+
+}  // namespace gpupixel
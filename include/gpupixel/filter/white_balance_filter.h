@@ -16,6 +16,7 @@ class GPUPIXEL_API WhiteBalanceFilter : public Filter {
   static std::shared_ptr<WhiteBalanceFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  std::string GetFingerprint() const override;
 
   void setTemperature(float temperature);
   void setTint(float tint);
@@ -11,23 +11,30 @@
 #include "gpupixel/gpupixel_define.h"
 // utils
 #include "gpupixel/utils/math_toolbox.h"
+#include "gpupixel/utils/quality_governor.h"
+#include "gpupixel/utils/triple_buffer.h"
 
 // source
 #include "gpupixel/source/source.h"
 #include "gpupixel/source/source_image.h"
 #include "gpupixel/source/source_raw_data.h"
+#include "gpupixel/source/source_texture.h"
 
 // sink
 #include "gpupixel/sink/sink.h"
 #include "gpupixel/sink/sink_raw_data.h"
 #include "gpupixel/sink/sink_render.h"
+#include "gpupixel/sink/sink_statistics.h"
+#include "gpupixel/sink/sink_texture.h"
 #if defined(GPUPIXEL_MAC) || defined(GPUPIXEL_IOS)
 #include "gpupixel/sink/sink_view.h"
 #endif
 // face detect
+#include "gpupixel/face_detector/face_detection_service.h"
 #include "gpupixel/face_detector/face_detector.h"
 
 // base filters
+#include "gpupixel/filter/compute_filter.h"
 #include "gpupixel/filter/filter.h"
 #include "gpupixel/filter/filter_group.h"
 
@@ -45,12 +52,14 @@
 #include "gpupixel/filter/brightness_filter.h"
 #include "gpupixel/filter/canny_edge_detection_filter.h"
 #include "gpupixel/filter/color_invert_filter.h"
+#include "gpupixel/filter/color_lut_filter.h"
 #include "gpupixel/filter/color_matrix_filter.h"
 #include "gpupixel/filter/contrast_filter.h"
 #include "gpupixel/filter/convolution3x3_filter.h"
 #include "gpupixel/filter/crosshatch_filter.h"
 #include "gpupixel/filter/directional_non_maximum_suppression_filter.h"
 #include "gpupixel/filter/directional_sobel_edge_detection_filter.h"
+#include "gpupixel/filter/dual_kawase_blur_filter.h"
 #include "gpupixel/filter/emboss_filter.h"
 #include "gpupixel/filter/exposure_filter.h"
 #include "gpupixel/filter/gaussian_blur_filter.h"
@@ -74,6 +83,7 @@
 #include "gpupixel/filter/smooth_toon_filter.h"
 #include "gpupixel/filter/sobel_edge_detection_filter.h"
 #include "gpupixel/filter/sphere_refraction_filter.h"
+#include "gpupixel/filter/stencil_chain_filter.h"
 #include "gpupixel/filter/toon_filter.h"
 #include "gpupixel/filter/weak_pixel_inclusion_filter.h"
 #include "gpupixel/filter/white_balance_filter.h"
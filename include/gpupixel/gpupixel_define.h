@@ -78,8 +78,33 @@ typedef enum GPUPIXEL_API {
   GPUPIXEL_FRAME_TYPE_YUVI420,
   GPUPIXEL_FRAME_TYPE_RGBA,
   GPUPIXEL_FRAME_TYPE_BGRA,
+  GPUPIXEL_FRAME_TYPE_NV12,
+  GPUPIXEL_FRAME_TYPE_NV21,
+  // Packed 4:2:2, Y0 U Y1 V and U Y0 V Y1
+  GPUPIXEL_FRAME_TYPE_YUY2,
+  GPUPIXEL_FRAME_TYPE_UYVY,
 } GPUPIXEL_FRAME_TYPE;
 
+// YUV to RGB conversion, limited range has luma in [16, 235] and chroma in
+// [16, 240]
+typedef enum GPUPIXEL_API {
+  GPUPIXEL_COLOR_SPACE_BT601_FULL,
+  GPUPIXEL_COLOR_SPACE_BT601_LIMITED,
+  GPUPIXEL_COLOR_SPACE_BT709_FULL,
+  GPUPIXEL_COLOR_SPACE_BT709_LIMITED,
+} GPUPIXEL_COLOR_SPACE;
+
+// Texel format of a filter's output. Formats the context cannot render to
+// fall back to RGBA8.
+typedef enum GPUPIXEL_API {
+  GPUPIXEL_FRAMEBUFFER_FORMAT_RGBA8,
+  // Single channel, sampled as (r, r, r, 1) so any shader can read it
+  GPUPIXEL_FRAMEBUFFER_FORMAT_R8,
+  // Two channels, sampled as (r, g, 0, 1)
+  GPUPIXEL_FRAMEBUFFER_FORMAT_RG8,
+  GPUPIXEL_FRAMEBUFFER_FORMAT_RGBA16F,
+} GPUPIXEL_FRAMEBUFFER_FORMAT;
+
 typedef enum GPUPIXEL_API {
   GPUPIXEL_MODE_FMT_VIDEO,
   GPUPIXEL_MODE_FMT_PICTURE,
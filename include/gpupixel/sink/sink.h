@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <map>
 #include "gpupixel/gpupixel_define.h"
@@ -37,7 +38,12 @@ class GPUPIXEL_API Sink {
   virtual bool IsReady() const;
   virtual void ResetAndClean();
   virtual void Render() {};
+  // Whether the sink takes part in SourceRawData::Prepare() frames. Sinks
+  // whose output leaves the graph, e.g. to a window, stay out of them.
+  virtual bool RendersPrepareFrames() const { return false; }
   virtual int NextAvailableTextureIndex() const;
+  // Marks an input as taken for NextAvailableTextureIndex(), from any thread
+  void ReserveInput(int tex_idx);
   // virtual void SetInputSizeWithIdx(int width, int height, int texture_idx)
   // {};
  protected:
@@ -50,6 +56,9 @@ class GPUPIXEL_API Sink {
 
   std::map<int, InputFrameBufferInfo> input_framebuffers_;
   int input_count_;
+  // Bit per input index a source was connected to, the map above belongs to
+  // the render thread
+  std::atomic<uint32_t> reserved_inputs_{0};
 };
 
 }  // namespace gpupixel
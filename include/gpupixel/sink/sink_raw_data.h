@@ -9,10 +9,12 @@
 #pragma once
 
 #include <stdio.h>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "gpupixel/sink/sink.h"
 
@@ -23,24 +25,74 @@
 
 namespace gpupixel {
 class GPUPixelGLProgram;
+
+// Pixels of one output frame in pool memory. I420 planes are contiguous,
+// U and V follow Y with half the stride.
+struct GPUPIXEL_API OutputFrame {
+  uint8_t* data = nullptr;
+  int width = 0;
+  int height = 0;
+  int stride = 0;
+  GPUPIXEL_FRAME_TYPE type = GPUPIXEL_FRAME_TYPE_RGBA;
+};
+
+// The frame's memory goes back to the pool when the last handle is dropped,
+// which may happen on any thread and after the sink is gone
+using OutputFrameHandle = std::shared_ptr<const OutputFrame>;
+
 class GPUPIXEL_API SinkRawData : public Sink {
  public:
   static std::shared_ptr<SinkRawData> Create();
   virtual ~SinkRawData();
   void Render() override;
+  bool RendersPrepareFrames() const override { return true; }
 
+  // Owned by the sink and overwritten by the next call
   const uint8_t* GetRgbaBuffer();
   const uint8_t* GetI420Buffer();
   int GetWidth() const { return width_; }
   int GetHeight() const { return height_; }
 
+  // Read the last frame straight into caller memory, which holds |width| x
+  // |height| pixels. Strides are in bytes, 0 for tightly packed rows. Return
+  // false before the first frame or when the frame has another size.
+  bool ReadRgba(uint8_t* buffer, int width, int height, int stride = 0);
+  bool ReadI420(uint8_t* data_y,
+                int stride_y,
+                uint8_t* data_u,
+                int stride_u,
+                uint8_t* data_v,
+                int stride_v,
+                int width,
+                int height);
+
+  // Registers caller memory, e.g. memfd or other shared mappings, for the
+  // frame pool. The memory must outlive the sink and every handle. Once any
+  // buffer is registered the pool only hands out registered buffers,
+  // otherwise it allocates and recycles its own.
+  void AddOutputBuffer(uint8_t* buffer, size_t size);
+
+  // Last frame in a pooled buffer, null before the first frame or when every
+  // registered buffer is in use
+  OutputFrameHandle AcquireRgbaFrame();
+  OutputFrameHandle AcquireI420Frame();
+
  private:
-  int RenderToOutput();
+  struct FramePool;
+
+  // GL thread, for the current frame size
+  int RenderToOutput(uint8_t* buffer, int stride);
+  void ConvertToI420(uint8_t* data_y,
+                     int stride_y,
+                     uint8_t* data_u,
+                     int stride_u,
+                     uint8_t* data_v,
+                     int stride_v);
   bool InitWithShaderString(const std::string& vertex_shader_source,
                             const std::string& fragment_shader_source);
   void InitTextureCache(int width, int height);
   void InitFramebuffer(int width, int height);
-  void InitOutputBuffer(int width, int height);
+  OutputFrameHandle AcquireFrame(GPUPIXEL_FRAME_TYPE type);
 
  private:
   SinkRawData();
@@ -53,13 +105,17 @@ class GPUPIXEL_API SinkRawData : public Sink {
 
   bool is_initialized_ = false;
 
-  // Image dimensions
-  int32_t width_ = 0;
-  int32_t height_ = 0;
+  // Image dimensions, set on the GL thread
+  std::atomic<int32_t> width_{0};
+  std::atomic<int32_t> height_{0};
+
+  // Frame buffers for pixel data, allocated on first use
+  std::vector<uint8_t> rgba_buffer_;  // RGBA buffer
+  std::vector<uint8_t> yuv_buffer_;   // YUV buffer
+  // RGBA read back for the I420 conversion, GL thread only
+  std::vector<uint8_t> conversion_buffer_;
 
-  // Frame buffers for pixel data
-  uint8_t* rgba_buffer_ = nullptr;  // RGBA buffer
-  uint8_t* yuv_buffer_ = nullptr;   // YUV buffer
+  std::shared_ptr<FramePool> pool_;
 };
 
 }  // namespace gpupixel
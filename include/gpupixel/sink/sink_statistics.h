@@ -0,0 +1,102 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "gpupixel/gpupixel_define.h"
+#include "gpupixel/sink/sink.h"
+
+namespace gpupixel {
+class GPUPixelGLProgram;
+
+// Histograms over 8-bit values. Luminance uses the same weights as
+// GrayscaleFilter. Values are in 0.0 - 1.0.
+struct GPUPIXEL_API ImageStatistics {
+  std::array<uint32_t, 256> luminance_histogram = {};
+  std::array<uint32_t, 256> red_histogram = {};
+  std::array<uint32_t, 256> green_histogram = {};
+  std::array<uint32_t, 256> blue_histogram = {};
+  // Pixels counted, kSampleGridSize squared on the sampling path, where all
+  // values below are estimates from those samples
+  uint32_t sample_count = 0;
+
+  float mean_luminance = 0.0;
+  float min_luminance = 0.0;
+  float max_luminance = 0.0;
+  float mean_red = 0.0;
+  float mean_green = 0.0;
+  float mean_blue = 0.0;
+
+  // Luminance below which |percentile| (0.0 - 1.0) of the samples lie
+  float GetLuminancePercentile(float percentile) const;
+};
+
+// Computes image statistics on the GPU and hands them to a callback one frame
+// later, without stalling on the frame being rendered. With compute shaders
+// every pixel is binned with atomics and only the 4KB of histograms are read
+// back; otherwise the input is sampled into a 64x64 framebuffer which is
+// read back, asynchronously where the context has pixel pack buffers, and
+// binned on the CPU.
+//
+// Sampling reads one bilinear sample per grid cell rather than reducing the
+// image, so its min, max and percentiles can miss small highlights or
+// shadows. Means stay close, the histograms' shape is approximate.
+//
+// The callback runs on the GL thread from Render(), typically setting
+// properties of ExposureFilter, WhiteBalanceFilter or LuminanceRangeFilter
+// that take effect on the following frame.
+class GPUPIXEL_API SinkStatistics : public Sink {
+ public:
+  using StatisticsCallback = std::function<void(const ImageStatistics&)>;
+
+  static std::shared_ptr<SinkStatistics> Create();
+  ~SinkStatistics();
+  void Render() override;
+
+  void SetCallback(StatisticsCallback callback);
+  // Last statistics delivered, may be called from any thread
+  ImageStatistics GetStatistics();
+
+  static constexpr int kSampleGridSize = 64;
+
+ private:
+  SinkStatistics();
+  bool Init();
+
+  void RenderWithCompute();
+  void RenderWithSampling();
+  void ReadSamplesAsync();
+  void Deliver(const uint32_t* histograms, uint32_t sample_count);
+  void BinSamples(const uint8_t* rgba);
+
+  GPUPixelGLProgram* program_ = nullptr;
+  bool using_compute_ = false;
+
+  // Two buffers alternate, one is written while the other is read back
+  uint32_t buffers_[2] = {0, 0};
+  bool pending_[2] = {false, false};
+  uint32_t sample_count_[2] = {0, 0};
+  int current_ = 0;
+
+  // Sampling path
+  std::shared_ptr<GPUPixelFramebuffer> sample_framebuffer_;
+  uint32_t position_attribute_ = 0;
+  uint32_t tex_coord_attribute_ = 0;
+  std::vector<uint8_t> samples_;
+  std::vector<uint32_t> bins_;
+
+  std::mutex mutex_;
+  StatisticsCallback callback_;
+  ImageStatistics statistics_;
+};
+
+}  // namespace gpupixel
@@ -0,0 +1,57 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "gpupixel/sink/sink.h"
+
+namespace gpupixel {
+
+// Exposes the texture of the graph's output instead of reading it back, for
+// encoders or renderers that consume GL textures from a shared context.
+//
+// The sink keeps the framebuffer it was handed alive, so its texture id
+// stays valid until the next frame arrives or the sink is destroyed. The
+// contents are overwritten by the next frame; consumers on another context
+// wait on the frame's fence first, e.g. with glWaitSync(fence.get()). The
+// fence is a GLsync shared with the consumer, deleted on the GL thread once
+// the last reference is dropped. Without sync objects (macOS, iOS, ES 2.0)
+// it is null and the GL thread has flushed.
+// The input's rotation is not applied, connect the sink to a filter when the
+// source is rotated.
+class GPUPIXEL_API SinkTexture : public Sink {
+ public:
+  using Fence = std::shared_ptr<void>;
+  using FrameCallback = std::function<
+      void(uint32_t texture, int width, int height, Fence fence)>;
+
+  static std::shared_ptr<SinkTexture> Create();
+  ~SinkTexture();
+  void Render() override;
+
+  // Called on the GL thread for every frame
+  void SetFrameCallback(FrameCallback callback);
+
+  // Last frame, 0 before the first one
+  uint32_t GetTexture();
+  int GetWidth();
+  int GetHeight();
+  Fence GetFence();
+
+ private:
+  SinkTexture();
+
+  std::mutex mutex_;
+  FrameCallback callback_;
+  std::shared_ptr<GPUPixelFramebuffer> framebuffer_;
+  Fence fence_;
+};
+
+}  // namespace gpupixel
@@ -13,8 +13,30 @@
 #include "gpupixel/sink/sink.h"
 
 namespace gpupixel {
+
+// Graph edits are published to the render thread as immutable snapshots it
+// pins for a whole frame, so editing from any thread neither races with
+// rendering nor waits for it. The edits made on one thread while a
+// GraphEdit is alive reach the render thread together, e.g. when switching
+// presets:
+//
+//   {
+//     GraphEdit edit;
+//     source->RemoveSink(old_preset);
+//     source->AddSink(new_preset)->AddSink(sink);
+//   }
+class GPUPIXEL_API GraphEdit {
+ public:
+  GraphEdit();
+  ~GraphEdit();
+  GraphEdit(const GraphEdit&) = delete;
+  GraphEdit& operator=(const GraphEdit&) = delete;
+};
+
 class GPUPIXEL_API Source {
  public:
+  using SinkMap = std::map<std::shared_ptr<Sink>, int>;
+
   Source();
   virtual ~Source();
   virtual std::shared_ptr<Source> AddSink(std::shared_ptr<Sink> sink);
@@ -23,7 +45,9 @@ class GPUPIXEL_API Source {
   virtual void RemoveSink(std::shared_ptr<Sink> sink);
   virtual void RemoveAllSinks();
   virtual bool HasSink(const std::shared_ptr<Sink> sink) const;
-  virtual std::map<std::shared_ptr<Sink>, int>& GetSinks() { return sinks_; };
+  // The sinks as the calling thread sees them, shared with the graph's
+  // snapshot and never changed, an edit publishes a new map
+  virtual std::shared_ptr<const SinkMap> GetSinks() const;
 
   virtual void SetFramebuffer(
       std::shared_ptr<GPUPixelFramebuffer> fb,
@@ -34,6 +58,7 @@ class GPUPIXEL_API Source {
   void SetFramebufferScale(float framebufferScale) {
     framebuffer_scale_ = framebufferScale;
   }
+  float GetFramebufferScale() const { return framebuffer_scale_; }
   int GetRotatedFramebufferWidth() const;
   int GetRotatedFramebufferHeight() const;
 
@@ -43,7 +68,6 @@ class GPUPIXEL_API Source {
  protected:
   std::shared_ptr<GPUPixelFramebuffer> framebuffer_;
   RotationMode output_rotation_;
-  std::map<std::shared_ptr<Sink>, int> sinks_;
   float framebuffer_scale_;
 };
 
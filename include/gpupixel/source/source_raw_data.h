@@ -14,12 +14,38 @@
 
 namespace gpupixel {
 class GPUPixelGLProgram;
+class GPUPixelTextureUploader;
 class GPUPIXEL_API SourceRawData : public Filter {
  public:
   static std::shared_ptr<SourceRawData> Create();
 
   ~SourceRawData() override;
 
+  // A frame in caller memory. Planes don't need to be contiguous and rows
+  // may be padded, they are read in place.
+  struct Frame {
+    GPUPIXEL_FRAME_TYPE type = GPUPIXEL_FRAME_TYPE_RGBA;
+    int width = 0;
+    int height = 0;
+    // Y, U and V for I420, Y and interleaved chroma for NV12 and NV21, a
+    // single plane otherwise
+    const uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+    // Bytes per row of each plane, 0 for tightly packed rows
+    int strides[3] = {0, 0, 0};
+    // Region to process, the whole frame when the size is 0. Rounded down to
+    // whole chroma samples for subsampled formats.
+    int crop_x = 0;
+    int crop_y = 0;
+    int crop_width = 0;
+    int crop_height = 0;
+    RotationMode rotation = NoRotation;
+  };
+
+  void ProcessFrame(const Frame& frame);
+
+  // Contiguous frame, chroma planes follow the luma plane. |stride| is the
+  // row size in bytes of the first plane, 0 for tightly packed rows. Applies
+  // the rotation set with SetRotation().
   void ProcessData(const uint8_t* data,
                    int width,
                    int height,
@@ -28,33 +54,68 @@ class GPUPIXEL_API SourceRawData : public Filter {
 
   void SetRotation(RotationMode rotation);
 
+  // Renders a blank frame of this size and type through the graph, so that
+  // the first real ones don't stall on allocating framebuffers and upload
+  // textures or on the driver setting up its state. Sinks whose output
+  // leaves the graph sit it out and SinkRawData keeps its last frame. Can be
+  // called ahead of a resolution change, the running stream keeps its
+  // resources and the new size's framebuffers wait in the factory's pool.
+  void Prepare(int width, int height, GPUPIXEL_FRAME_TYPE type);
+
+  // Conversion matrix and range of YUV frames, BT.601 full range by default
+  void SetColorSpace(GPUPIXEL_COLOR_SPACE color_space);
+
   bool Init();
 
  private:
   SourceRawData();
-  int GenerateTextureWithI420(int width,
-                              int height,
-                              const uint8_t* dataY,
-                              int strideY,
-                              const uint8_t* dataU,
-                              int strideU,
-                              const uint8_t* dataV,
-                              int strideV);
-
-  int GenerateTextureWithPixels(const uint8_t* pixels,
-                                int width,
-                                int height,
-                                int stride,
-                                GPUPIXEL_FRAME_TYPE type);
+
+  // A plane of the cropped region and the uploader it goes to
+  struct UploadPlane {
+    GPUPixelTextureUploader* uploader;
+    const uint8_t* data;
+    int width;
+    int height;
+    int stride;
+  };
+
+  // Frame of a contiguous buffer, as passed to ProcessData()
+  Frame ContiguousFrame(const uint8_t* data,
+                        int width,
+                        int height,
+                        int stride,
+                        GPUPIXEL_FRAME_TYPE type) const;
+
+  // A prepare frame isn't staged and leaves allocated uploaders alone
+  void SubmitFrame(const Frame& frame, bool prepare);
+
+  // Whether every sink applies the input rotation when sampling
+  bool CanSinksRotate(RotationMode rotation);
+
+  // Uploads the planes to units 0, 1 and 2, converts them into framebuffer_
+  // unless they can be published as they are, and updates the sinks
+  void RenderPlanes(const UploadPlane* planes,
+                    int plane_count,
+                    uint32_t format,
+                    int width,
+                    int height,
+                    int texture_type,
+                    RotationMode rotation);
 
  private:
   GPUPixelGLProgram* filter_program_;
   uint32_t filter_position_attribute_;
   uint32_t filter_tex_coord_attribute_;
 
-  uint32_t textures_[4] = {0};
+  // Y, U and V planes, interleaved chroma, and packed RGBA or YUV
+  std::unique_ptr<GPUPixelTextureUploader> plane_uploaders_[3];
+  std::unique_ptr<GPUPixelTextureUploader> uv_uploader_;
+  std::unique_ptr<GPUPixelTextureUploader> rgba_uploader_;
   RotationMode rotation_ = NoRotation;
+  GPUPIXEL_COLOR_SPACE color_space_ = GPUPIXEL_COLOR_SPACE_BT601_FULL;
   std::shared_ptr<GPUPixelFramebuffer> framebuffer_;
+  // Wraps the RGBA upload texture when no conversion pass is needed
+  std::shared_ptr<GPUPixelFramebuffer> upload_framebuffer_;
 };
 
 }  // namespace gpupixel
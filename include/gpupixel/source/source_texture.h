@@ -0,0 +1,65 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include "gpupixel/source/source.h"
+
+namespace gpupixel {
+class GPUPixelGLProgram;
+
+// Feeds textures the application already has on the GPU, e.g. decoder
+// surfaces or another renderer's output, into the graph without a copy.
+//
+// The texture must belong to a context sharing objects with GPUPixel's and
+// be complete when ProcessTexture() is called; the frame is rendered before
+// it returns and the texture is not referenced afterwards. Producers on
+// another context must flush, or fence, before handing the texture over.
+//
+// GL_TEXTURE_2D textures are handed to the sinks as they are, with the
+// rotation applied by the first consumer. External OES textures (Android
+// SurfaceTexture and EGLImage) cannot be sampled by ordinary filters and are
+// drawn into an RGBA framebuffer once.
+class GPUPIXEL_API SourceTexture : public Source {
+ public:
+  enum TextureTarget {
+    kTexture2D = 0,
+    kTextureExternalOES,
+  };
+
+  static std::shared_ptr<SourceTexture> Create();
+  ~SourceTexture() override;
+
+  void ProcessTexture(uint32_t texture,
+                      int width,
+                      int height,
+                      TextureTarget target = kTexture2D);
+
+  void SetRotation(RotationMode rotation);
+  // Column major 4x4 texture coordinate transform of external textures, as
+  // reported by SurfaceTexture.getTransformMatrix(). Identity by default.
+  void SetExternalTextureTransform(const float* matrix);
+
+ private:
+  SourceTexture();
+  bool InitExternalProgram();
+  void RenderExternal(uint32_t texture, int width, int height);
+
+  RotationMode rotation_ = NoRotation;
+  float external_transform_[16] = {1, 0, 0, 0, 0, 1, 0, 0,
+                                   0, 0, 1, 0, 0, 0, 0, 1};
+
+  // Wrapper of the last 2D texture, reused while it doesn't change
+  std::shared_ptr<GPUPixelFramebuffer> wrapped_framebuffer_;
+
+  GPUPixelGLProgram* external_program_ = nullptr;
+  uint32_t external_position_attribute_ = 0;
+  uint32_t external_tex_coord_attribute_ = 0;
+  std::shared_ptr<GPUPixelFramebuffer> external_framebuffer_;
+};
+
+}  // namespace gpupixel
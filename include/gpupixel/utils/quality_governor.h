@@ -0,0 +1,118 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+class Filter;
+class Source;
+
+// One rung of a quality ladder. Settings are absolute, the governor moves up
+// and down the ladder, so each level sets every knob any level touches.
+// Filters and sources are held weakly.
+class GPUPIXEL_API QualityLevel {
+ public:
+  explicit QualityLevel(const std::string& name = "");
+
+  QualityLevel& SetFramebufferScale(std::shared_ptr<Source> source,
+                                    float scale);
+  QualityLevel& SetProperty(std::shared_ptr<Filter> filter,
+                            const std::string& property,
+                            float value);
+  QualityLevel& SetProperty(std::shared_ptr<Filter> filter,
+                            const std::string& property,
+                            int value);
+  // Anything else, e.g. the app's face detection interval
+  QualityLevel& Run(std::function<void()> action);
+
+  const std::string& GetName() const { return name_; }
+  void Apply() const;
+
+ private:
+  std::string name_;
+  std::vector<std::function<void()>> actions_;
+};
+
+// Keeps frame time within a budget by stepping through a quality ladder.
+// Level 0 is the best quality and assumed to be in effect initially. The
+// average frame time over a window is compared against the target: above
+// target * degrade_ratio the next level is applied, below
+// target * upgrade_ratio the previous one. Each change is followed by a hold
+// period, longer for upgrades, so the governor does not oscillate around the
+// budget.
+//
+// Frame time is measured between BeginFrame() and EndFrame(), which should
+// enclose the processing of one frame including its readback, or reported
+// directly with ReportFrameTime(). Level changes are applied on the thread
+// that ends the frame, one at a time, so level actions and the level changed
+// callback must not call back into the governor.
+class GPUPIXEL_API QualityGovernor {
+ public:
+  struct Options {
+    float target_frame_ms = 33.0f;
+    float degrade_ratio = 1.1f;
+    float upgrade_ratio = 0.75f;
+    // Frames averaged before a decision
+    int window_frames = 30;
+    // Frames to wait after a change before the next step down or up
+    int degrade_hold_frames = 30;
+    int upgrade_hold_frames = 120;
+  };
+
+  using LevelChangedCallback =
+      std::function<void(int level, const std::string& name)>;
+
+  static std::shared_ptr<QualityGovernor> Create();
+  static std::shared_ptr<QualityGovernor> Create(const Options& options);
+  ~QualityGovernor();
+
+  void AddLevel(const QualityLevel& level);
+  void SetLevelChangedCallback(LevelChangedCallback callback);
+
+  void BeginFrame();
+  void EndFrame();
+  void ReportFrameTime(float frame_ms);
+
+  // Applies |level| immediately and restarts the hold period
+  void SetLevel(int level);
+  int GetLevel();
+  std::string GetLevelName();
+  int GetLevelCount();
+  // Average over the current window, 0 before the first frame
+  float GetAverageFrameTime();
+
+ private:
+  QualityGovernor(const Options& options);
+  // Returns the level to apply, -1 for none. Called with |mutex_| held.
+  int Evaluate(float frame_ms);
+  // Called with |apply_mutex_| held
+  void ApplyLevel(int level);
+
+  Options options_;
+  // Serialises choosing a level with applying it, taken before |mutex_|
+  std::mutex apply_mutex_;
+  std::mutex mutex_;
+  std::vector<QualityLevel> levels_;
+  LevelChangedCallback callback_;
+  int level_ = 0;
+
+  std::vector<float> window_;
+  size_t window_index_ = 0;
+  float window_sum_ = 0.0f;
+  int frames_since_change_ = 0;
+  std::chrono::steady_clock::time_point frame_start_;
+};
+
+}  // namespace gpupixel
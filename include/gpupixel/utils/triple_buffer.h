@@ -0,0 +1,74 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace gpupixel {
+
+// Hands the latest value from a writer thread to a reader thread without
+// locks. The writer fills its own slot and swaps it for the shared one, the
+// reader swaps its slot for the shared one when a newer value was published.
+// Neither side ever waits, intermediate values may be skipped. Writers of
+// one buffer must not run concurrently.
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Not thread safe, for initialization only
+  void Reset(const T& value) {
+    for (T& slot : slots_) {
+      slot = value;
+    }
+    back_ = 0;
+    last_ = 0;
+    front_ = 1;
+    shared_.store(2, std::memory_order_release);
+  }
+
+  // Writer side
+  void Write(const T& value) {
+    slots_[back_] = value;
+    last_ = back_;
+    back_ = shared_.exchange(back_ | kDirty, std::memory_order_acq_rel) &
+            kIndexMask;
+  }
+
+  // Last value written, on the writer thread. The reader never writes to
+  // that slot and the writer doesn't reuse it before the next Write().
+  const T& Latest() const { return slots_[last_]; }
+
+  // Reader side, false when nothing was written since the last call
+  bool Read(T& value) {
+    if (!(shared_.load(std::memory_order_relaxed) & kDirty)) {
+      return false;
+    }
+    front_ = shared_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+    value = slots_[front_];
+    return true;
+  }
+
+ private:
+  static constexpr uint8_t kIndexMask = 3;
+  static constexpr uint8_t kDirty = 4;
+
+  T slots_[3] = {};
+  // Owned by the writer
+  uint8_t back_ = 0;
+  uint8_t last_ = 0;
+  // Owned by the reader
+  uint8_t front_ = 1;
+  // Index of the published slot, with kDirty until the reader takes it
+  std::atomic<uint8_t> shared_{2};
+};
+
+}  // namespace gpupixel
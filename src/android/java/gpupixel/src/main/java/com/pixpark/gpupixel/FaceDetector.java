@@ -7,6 +7,8 @@
 
 package com.pixpark.gpupixel;
 
+import java.nio.ByteBuffer;
+
 /**
  * Face detector class for detecting facial landmarks in images
  */
@@ -21,6 +23,8 @@ public class FaceDetector {
     public static final int GPUPIXEL_FRAME_TYPE_YUVI420 = 0;
     public static final int GPUPIXEL_FRAME_TYPE_RGBA = 1;
     public static final int GPUPIXEL_FRAME_TYPE_BGRA = 2;
+    public static final int GPUPIXEL_FRAME_TYPE_NV12 = 3;
+    public static final int GPUPIXEL_FRAME_TYPE_NV21 = 4;
 
     /**
      * Create a face detector instance
@@ -43,17 +47,51 @@ public class FaceDetector {
      * @param width Image width
      * @param height Image height
      * @param format Image format (GPUPIXEL_MODE_FMT_VIDEO or GPUPIXEL_MODE_FMT_PICTURE)
-     * @param frameType Frame type (GPUPIXEL_FRAME_TYPE_YUVI420, GPUPIXEL_FRAME_TYPE_RGBA or
-     *         GPUPIXEL_FRAME_TYPE_BGRA)
+     * @param stide Row pitch in bytes of the first plane, chroma planes of YUV frames
+     *         must follow the luma plane contiguously
+     * @param frameType Frame type (GPUPIXEL_FRAME_TYPE_YUVI420, GPUPIXEL_FRAME_TYPE_RGBA,
+     *         GPUPIXEL_FRAME_TYPE_BGRA, GPUPIXEL_FRAME_TYPE_NV12 or GPUPIXEL_FRAME_TYPE_NV21)
      * @return Array of facial landmark coordinates, each landmark consists of x,y values
      */
     public float[] detect(final byte[] data, final int width, final int height, final int stide,
             final int format, final int frameType) {
+        return detect(data, width, height, stide, format, frameType, 0);
+    }
+
+    /**
+     * Detect facial landmarks on a rotated frame
+     * @param rotation Clockwise rotation (0, 90, 180 or 270) that makes the frame upright,
+     *         the landmarks are normalized to the upright frame
+     * @see #detect(byte[], int, int, int, int, int)
+     */
+    public float[] detect(final byte[] data, final int width, final int height, final int stide,
+            final int format, final int frameType, final int rotation) {
         if (mNativeClassID == 0) {
             return new float[0];
         }
         return nativeFaceDetectorDetect(
-                mNativeClassID, data, width, height, stide, format, frameType);
+                mNativeClassID, data, width, height, stide, format, frameType, rotation);
+    }
+
+    /**
+     * Detect facial landmarks on the planes of a YUV frame, e.g. those of an
+     * android.media.Image, without a colour conversion
+     * @param dataY Luma plane, a direct buffer
+     * @param dataU Chroma plane, the interleaved one for NV12/NV21, a direct buffer
+     * @param dataV Second chroma plane for I420, ignored for NV12/NV21
+     * @param frameType GPUPIXEL_FRAME_TYPE_YUVI420, GPUPIXEL_FRAME_TYPE_NV12 or
+     *         GPUPIXEL_FRAME_TYPE_NV21
+     * @return Array of facial landmark coordinates, detected on luma only when the chroma
+     *         planes don't follow the luma plane in memory
+     */
+    public float[] detectYUV(final ByteBuffer dataY, final int strideY, final ByteBuffer dataU,
+            final int strideU, final ByteBuffer dataV, final int strideV, final int width,
+            final int height, final int format, final int frameType, final int rotation) {
+        if (mNativeClassID == 0) {
+            return new float[0];
+        }
+        return nativeFaceDetectorDetectYUV(mNativeClassID, dataY, strideY, dataU, strideU, dataV,
+                strideV, width, height, format, frameType, rotation);
     }
 
     /**
@@ -82,5 +120,8 @@ public class FaceDetector {
     private static native long nativeFaceDetectorCreate();
     private static native void nativeFaceDetectorDestroy(long classId);
     private static native float[] nativeFaceDetectorDetect(long classId, byte[] data, int width,
-            int height, int stride, int format, int frameType);
+            int height, int stride, int format, int frameType, int rotation);
+    private static native float[] nativeFaceDetectorDetectYUV(long classId, ByteBuffer dataY,
+            int strideY, ByteBuffer dataU, int strideU, ByteBuffer dataV, int strideV, int width,
+            int height, int format, int frameType, int rotation);
 }
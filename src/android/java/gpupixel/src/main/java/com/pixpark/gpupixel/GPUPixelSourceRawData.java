@@ -12,6 +12,16 @@ public class GPUPixelSourceRawData extends GPUPixelSource {
     public static final int FRAME_TYPE_YUVI420 = 0;
     public static final int FRAME_TYPE_RGBA = 1;
     public static final int FRAME_TYPE_BGRA = 2;
+    public static final int FRAME_TYPE_NV12 = 3;
+    public static final int FRAME_TYPE_NV21 = 4;
+    public static final int FRAME_TYPE_YUY2 = 5;
+    public static final int FRAME_TYPE_UYVY = 6;
+
+    // YUV color spaces
+    public static final int COLOR_SPACE_BT601_FULL = 0;
+    public static final int COLOR_SPACE_BT601_LIMITED = 1;
+    public static final int COLOR_SPACE_BT709_FULL = 2;
+    public static final int COLOR_SPACE_BT709_LIMITED = 3;
 
     protected GPUPixelSourceRawData() {}
 
@@ -28,6 +38,11 @@ public class GPUPixelSourceRawData extends GPUPixelSource {
         nativeSetRotation(mNativeClassID, rotation);
     }
 
+    // Set YUV conversion matrix and range
+    public void SetColorSpace(int colorSpace) {
+        nativeSetColorSpace(mNativeClassID, colorSpace);
+    }
+
     // Unified data processing interface - accepts only byte[]
     public void ProcessData(byte[] data, int width, int height, int stride, int frameType) {
         nativeProcessData(mNativeClassID, data, width, height, stride, frameType);
@@ -61,4 +76,5 @@ public class GPUPixelSourceRawData extends GPUPixelSource {
     private static native void nativeProcessData(
             long nativeObj, byte[] data, int width, int height, int stride, int frameType);
     private static native void nativeSetRotation(long nativeObj, int rotation);
+    private static native void nativeSetColorSpace(long nativeObj, int colorSpace);
 }
@@ -18,6 +18,20 @@ using namespace gpupixel;
 // Global face detector list for managing face detector lifecycle
 std::list<std::shared_ptr<FaceDetector>> face_detector_list_;
 
+namespace {
+jfloatArray ToJavaFloatArray(JNIEnv* env, const std::vector<float>& values) {
+  // Create Java float array
+  jfloatArray result = env->NewFloatArray(values.size());
+  if (result == nullptr) {
+    return nullptr;
+  }
+
+  // Fill Java float array
+  env->SetFloatArrayRegion(result, 0, values.size(), values.data());
+  return result;
+}
+}  // namespace
+
 // Create face detector
 extern "C" JNIEXPORT jlong JNICALL
 Java_com_pixpark_gpupixel_FaceDetector_nativeFaceDetectorCreate(JNIEnv* env,
@@ -52,7 +66,8 @@ Java_com_pixpark_gpupixel_FaceDetector_nativeFaceDetectorDetect(
     jint height,
     jint stride,
     jint format,
-    jint frameType) {
+    jint frameType,
+    jint rotation) {
   // Get Java byte array
   jbyte* data = env->GetByteArrayElements(jData, nullptr);
 
@@ -60,19 +75,48 @@ Java_com_pixpark_gpupixel_FaceDetector_nativeFaceDetectorDetect(
   std::vector<float> landmarks =
       ((FaceDetector*)classId)
           ->Detect((const uint8_t*)data, width, height, stride,
-                   (GPUPIXEL_MODE_FMT)format, (GPUPIXEL_FRAME_TYPE)frameType);
+                   (GPUPIXEL_MODE_FMT)format, (GPUPIXEL_FRAME_TYPE)frameType,
+                   rotation);
 
   // Release Java byte array
   env->ReleaseByteArrayElements(jData, data, JNI_ABORT);
 
-  // Create Java float array
-  jfloatArray result = env->NewFloatArray(landmarks.size());
-  if (result == nullptr) {
-    return nullptr;
+  return ToJavaFloatArray(env, landmarks);
+}
+
+// Detect face landmarks on the planes of a YUV frame
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_pixpark_gpupixel_FaceDetector_nativeFaceDetectorDetectYUV(
+    JNIEnv* env,
+    jclass obj,
+    jlong classId,
+    jobject jDataY,
+    jint strideY,
+    jobject jDataU,
+    jint strideU,
+    jobject jDataV,
+    jint strideV,
+    jint width,
+    jint height,
+    jint format,
+    jint frameType,
+    jint rotation) {
+  // Direct buffers keep the planes' real addresses, so contiguous ones are
+  // detected with their chroma
+  auto data_y = (const uint8_t*)env->GetDirectBufferAddress(jDataY);
+  auto data_u =
+      jDataU ? (const uint8_t*)env->GetDirectBufferAddress(jDataU) : nullptr;
+  auto data_v =
+      jDataV ? (const uint8_t*)env->GetDirectBufferAddress(jDataV) : nullptr;
+  if (data_y == nullptr) {
+    return env->NewFloatArray(0);
   }
 
-  // Fill Java float array
-  env->SetFloatArrayRegion(result, 0, landmarks.size(), landmarks.data());
+  std::vector<float> landmarks =
+      ((FaceDetector*)classId)
+          ->DetectYUV(data_y, strideY, data_u, strideU, data_v, strideV, width,
+                      height, (GPUPIXEL_MODE_FMT)format,
+                      (GPUPIXEL_FRAME_TYPE)frameType, rotation);
 
-  return result;
+  return ToJavaFloatArray(env, landmarks);
 }
@@ -82,3 +82,16 @@ Java_com_pixpark_gpupixel_GPUPixelSourceRawData_nativeSetRotation(
     (*ptr)->SetRotation((RotationMode)rotation);
   }
 }
+
+// Set YUV color space
+extern "C" JNIEXPORT void JNICALL
+Java_com_pixpark_gpupixel_GPUPixelSourceRawData_nativeSetColorSpace(
+    JNIEnv* env,
+    jclass clazz,
+    jlong native_obj,
+    jint color_space) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<SourceRawData>*>(native_obj);
+  if (ptr && *ptr) {
+    (*ptr)->SetColorSpace((GPUPIXEL_COLOR_SPACE)color_space);
+  }
+}
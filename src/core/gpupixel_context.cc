@@ -6,6 +6,11 @@
  */
 
 #include "core/gpupixel_context.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "core/gpupixel_gl_compute.h"
 #include "utils/dispatch_queue.h"
 #include "utils/logging.h"
 #include "utils/util.h"
@@ -14,6 +19,15 @@
 #include <emscripten/html5.h>
 #endif
 
+#if defined(GPUPIXEL_ANDROID) && !defined(EGL_OPENGL_ES3_BIT_KHR)
+#define EGL_OPENGL_ES3_BIT_KHR 0x00000040
+#endif
+
+// Same value for the ARB extension
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace gpupixel {
 
 GPUPixelContext* GPUPixelContext::instance_ = 0;
@@ -30,8 +44,11 @@ GPUPixelContext::GPUPixelContext() : current_shader_program_(0) {
 
 GPUPixelContext::~GPUPixelContext() {
   LOG_DEBUG("Destroying GPUPixelContext");
-  ReleaseContext();
+  // Idle framebuffers go to the garbage, the task below collects it
   delete framebuffer_factory_;
+  delete warm_up_stand_in_;
+  SyncRunWithContext([] {});
+  ReleaseContext();
   task_queue_->stop();
 }
 
@@ -56,6 +73,13 @@ void GPUPixelContext::Init() {
   SyncRunWithContext([=] {
     LOG_INFO("Initializing GPUPixelContext");
     this->CreateContext();
+    // "OpenGL ES 3.2 ..." on GLES and WebGL, "4.6 ..." on desktop GL
+    const char* version = (const char*)glGetString(GL_VERSION);
+    while (version && *version && !isdigit(*version)) {
+      version++;
+    }
+    gl_major_version_ = version ? atoi(version) : 0;
+    LOG_INFO("OpenGL major version: {}", gl_major_version_);
   });
 }
 
@@ -73,6 +97,12 @@ void GPUPixelContext::SetActiveGlProgram(GPUPixelGLProgram* shaderProgram) {
 void GPUPixelContext::Clean() {
   LOG_DEBUG("Cleaning GPUPixelContext resources");
   framebuffer_factory_->Clean();
+  SyncRunWithContext([=] {
+    for (auto& warm : warm_programs_) {
+      ReleaseProgram(warm.second);
+    }
+    warm_programs_.clear();
+  });
 }
 
 void GPUPixelContext::CreateContext() {
@@ -136,37 +166,48 @@ void GPUPixelContext::CreateContext() {
   }
   LOG_DEBUG("EGL initialized: version major:{} minor:{}", major, minor);
 
-  // Configure EGL
-  const EGLint configAttribs[] = {EGL_RED_SIZE,
-                                  8,
-                                  EGL_GREEN_SIZE,
-                                  8,
-                                  EGL_BLUE_SIZE,
-                                  8,
-                                  EGL_ALPHA_SIZE,
-                                  8,
-                                  EGL_DEPTH_SIZE,
-                                  16,
-                                  EGL_STENCIL_SIZE,
-                                  0,
-                                  EGL_SURFACE_TYPE,
-                                  EGL_PBUFFER_BIT,
-                                  EGL_RENDERABLE_TYPE,
-                                  EGL_OPENGL_ES2_BIT,
-                                  EGL_NONE};
-
-  EGLint numConfigs;
-  if (!eglChooseConfig(egl_display_, configAttribs, &egl_config_, 1,
-                       &numConfigs)) {
-    LOG_ERROR("Failed to choose EGL config");
-    return;
-  }
-
-  // Create EGL context
-  const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+  // Configure EGL. GLES 3.0 brings the RG formats, immutable storage and
+  // the unpack buffers the uploads rely on, ES 2.0 is the fallback.
+  egl_context_ = EGL_NO_CONTEXT;
+  for (EGLint version : {3, 2}) {
+    const EGLint renderableType =
+        version == 3 ? EGL_OPENGL_ES3_BIT_KHR : EGL_OPENGL_ES2_BIT;
+    const EGLint configAttribs[] = {EGL_RED_SIZE,
+                                    8,
+                                    EGL_GREEN_SIZE,
+                                    8,
+                                    EGL_BLUE_SIZE,
+                                    8,
+                                    EGL_ALPHA_SIZE,
+                                    8,
+                                    EGL_DEPTH_SIZE,
+                                    16,
+                                    EGL_STENCIL_SIZE,
+                                    0,
+                                    EGL_SURFACE_TYPE,
+                                    EGL_PBUFFER_BIT,
+                                    EGL_RENDERABLE_TYPE,
+                                    renderableType,
+                                    EGL_NONE};
+
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(egl_display_, configAttribs, &egl_config_, 1,
+                         &numConfigs) ||
+        numConfigs == 0) {
+      LOG_WARN("No EGL config for OpenGL ES {}", version);
+      continue;
+    }
 
-  egl_context_ = eglCreateContext(egl_display_, egl_config_, EGL_NO_CONTEXT,
-                                  contextAttribs);
+    // Create EGL context
+    const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, version,
+                                     EGL_NONE};
+    egl_context_ = eglCreateContext(egl_display_, egl_config_, EGL_NO_CONTEXT,
+                                    contextAttribs);
+    if (egl_context_ != EGL_NO_CONTEXT) {
+      break;
+    }
+    LOG_WARN("Failed to create an OpenGL ES {} context", version);
+  }
   if (egl_context_ == EGL_NO_CONTEXT) {
     LOG_ERROR("Failed to create EGL context");
     return;
@@ -304,6 +345,63 @@ void GPUPixelContext::ReleaseContext() {
   LOG_INFO("OpenGL context released successfully");
 }
 
+bool GPUPixelContext::HasSyncObjects() const {
+#if defined(GPUPIXEL_GL_SYNC_OBJECTS)
+  return gl_major_version_ >= 3;
+#else
+  return false;
+#endif
+}
+
+bool GPUPixelContext::HasPixelBuffers() const {
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  return gl_major_version_ >= 3;
+#else
+  return false;
+#endif
+}
+
+bool GPUPixelContext::HasRGFormats() const {
+#if defined(GPUPIXEL_GL_RG_FORMATS)
+  return gl_major_version_ >= 3;
+#else
+  return false;
+#endif
+}
+
+bool GPUPixelContext::HasUnpackRowLength() const {
+#if defined(GPUPIXEL_MAC)
+  // Core since GL 1.1, only GLES 2.0 lacks it
+  return true;
+#elif defined(GPUPIXEL_GL_UNPACK_ROW_LENGTH)
+  return gl_major_version_ >= 3;
+#else
+  return false;
+#endif
+}
+
+bool GPUPixelContext::HasTextureStorage() const {
+#if defined(GPUPIXEL_GL_TEXTURE_STORAGE)
+  return gl_major_version_ >= 3;
+#else
+  return false;
+#endif
+}
+
+bool GPUPixelContext::IsComputeSupported() {
+  bool supported = false;
+  SyncRunWithContext([&] { supported = GetGLComputeFunctions() != nullptr; });
+  return supported;
+}
+
+bool GPUPixelContext::IsContextThread() const {
+#if defined(GPUPIXEL_WASM)
+  return true;
+#else
+  return task_queue_->isWorkerThread();
+#endif
+}
+
 void GPUPixelContext::SyncRunWithContext(std::function<void(void)> task) {
 #if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
   if (!Util::IsAppleAppActive()) {
@@ -315,12 +413,287 @@ void GPUPixelContext::SyncRunWithContext(std::function<void(void)> task) {
   LOG_TRACE("Running task synchronously (WebGL)");
   UseAsCurrent();
   task();
+  CollectGarbage();
 #else
   LOG_TRACE("Running task on task queue");
   task_queue_->runTask([=]() {
     UseAsCurrent();
     task();
+    CollectGarbage();
   });
 #endif
 }
+
+template <typename T>
+void GPUPixelContext::PostGarbage(std::vector<T>& handles, T handle) {
+  {
+    std::unique_lock<std::mutex> lock(garbage_mutex_);
+    handles.push_back(handle);
+  }
+  has_garbage_.store(true, std::memory_order_release);
+
+#if !defined(GPUPIXEL_WASM)
+  // Released off the GL thread, e.g. a graph torn down by the app, with no
+  // task to collect it
+  if (!task_queue_->isWorkerThread() && !garbage_task_queued_.exchange(true)) {
+    task_queue_->postTask([=] {
+      garbage_task_queued_ = false;
+#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
+      // Left for the next task, no GL work in the background
+      if (!Util::IsAppleAppActive()) {
+        return;
+      }
+#endif
+      if (has_garbage_) {
+        UseAsCurrent();
+        CollectGarbage();
+      }
+    });
+  }
+#endif
+}
+
+void GPUPixelContext::DeleteTexture(uint32_t texture) {
+  PostGarbage(garbage_textures_, texture);
+}
+
+void GPUPixelContext::DeleteFramebuffer(uint32_t framebuffer) {
+  PostGarbage(garbage_framebuffers_, framebuffer);
+}
+
+void GPUPixelContext::DeleteBuffer(uint32_t buffer) {
+  PostGarbage(garbage_buffers_, buffer);
+}
+
+void GPUPixelContext::DeleteSync(void* sync) {
+  PostGarbage(garbage_syncs_, sync);
+}
+
+void GPUPixelContext::RetainProgram(uint32_t program) {
+  program_refs_[program]++;
+}
+
+void GPUPixelContext::ReleaseProgram(uint32_t program) {
+  PostGarbage(garbage_programs_, program);
+}
+
+void GPUPixelContext::CollectGarbage() {
+  if (!has_garbage_.exchange(false, std::memory_order_acquire)) {
+    return;
+  }
+  std::vector<uint32_t> textures;
+  std::vector<uint32_t> framebuffers;
+  std::vector<uint32_t> buffers;
+  std::vector<uint32_t> programs;
+  std::vector<void*> syncs;
+  {
+    std::unique_lock<std::mutex> lock(garbage_mutex_);
+    textures.swap(garbage_textures_);
+    framebuffers.swap(garbage_framebuffers_);
+    buffers.swap(garbage_buffers_);
+    programs.swap(garbage_programs_);
+    syncs.swap(garbage_syncs_);
+  }
+
+#if defined(GPUPIXEL_GL_SYNC_OBJECTS)
+  for (void* sync : syncs) {
+    GL_CALL(glDeleteSync((GLsync)sync));
+  }
+#endif
+
+  if (!framebuffers.empty()) {
+    GL_CALL(glDeleteFramebuffers((GLsizei)framebuffers.size(),
+                                 framebuffers.data()));
+  }
+  if (!textures.empty()) {
+    GL_CALL(glDeleteTextures((GLsizei)textures.size(), textures.data()));
+  }
+  if (!buffers.empty()) {
+    GL_CALL(glDeleteBuffers((GLsizei)buffers.size(), buffers.data()));
+  }
+  for (uint32_t program : programs) {
+    auto it = program_refs_.find(program);
+    if (it != program_refs_.end() && --it->second > 0) {
+      continue;
+    }
+    if (it != program_refs_.end()) {
+      program_refs_.erase(it);
+    }
+    GL_CALL(glDeleteProgram(program));
+  }
+  if (!programs.empty()) {
+    // The cached program may be gone, and its address reused
+    current_shader_program_ = nullptr;
+  }
+}
+
+struct GPUPixelContext::WarmUp {
+  std::promise<bool> promise;
+  size_t remaining;
+  bool ok = true;
+  // Submitted by the builds, not checked yet
+  std::vector<std::pair<std::string, uint32_t>> programs;
+};
+
+std::future<bool> GPUPixelContext::WarmUpPrograms(
+    std::vector<std::function<bool()>> builds) {
+  auto warm_up = std::make_shared<WarmUp>();
+  warm_up->remaining = builds.size();
+  std::future<bool> future = warm_up->promise.get_future();
+  if (builds.empty()) {
+    warm_up->promise.set_value(true);
+    return future;
+  }
+
+  for (auto& build : builds) {
+    auto task = [=] {
+#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
+      bool active = Util::IsAppleAppActive();
+#else
+      bool active = true;
+#endif
+      bool ok = false;
+      if (active) {
+        UseAsCurrent();
+        EnableParallelShaderCompile();
+        if (!warm_up_stand_in_) {
+          warm_up_stand_in_ = GPUPixelGLProgram::CreateWithShaderString(
+              kDefaultVertexShader, kDefaultFragmentShader);
+        }
+        warm_up_depth_++;
+        ok = build();
+        warm_up_depth_--;
+        warm_up->programs.insert(warm_up->programs.end(),
+                                 compiling_programs_.begin(),
+                                 compiling_programs_.end());
+        compiling_programs_.clear();
+        CollectGarbage();
+      }
+      // Tasks run in order on the one GL thread
+      warm_up->ok = warm_up->ok && ok;
+      if (--warm_up->remaining == 0) {
+        FinishWarmUp(warm_up);
+      }
+    };
+#if defined(GPUPIXEL_WASM)
+    task();
+#else
+    task_queue_->postTask(task);
+#endif
+  }
+  return future;
+}
+
+void GPUPixelContext::FinishWarmUp(std::shared_ptr<WarmUp> warm_up) {
+#if !defined(GPUPIXEL_WASM)
+  // The link status would wait for the driver's compiler threads
+  if (has_parallel_shader_compile_) {
+    for (auto& compiling : warm_up->programs) {
+      GLint completed = GL_FALSE;
+      glGetProgramiv(compiling.second, GL_COMPLETION_STATUS_KHR, &completed);
+      if (completed == GL_FALSE) {
+        // Frames queued meanwhile go first
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        task_queue_->postTask([=] {
+          UseAsCurrent();
+          FinishWarmUp(warm_up);
+          CollectGarbage();
+        });
+        return;
+      }
+    }
+  }
+#endif
+
+  size_t linked_count = 0;
+  for (auto& compiling : warm_up->programs) {
+    GLint linked = GL_FALSE;
+    glGetProgramiv(compiling.second, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE) {
+      GLchar messages[256];
+      glGetProgramInfoLog(compiling.second, sizeof(messages), 0, &messages[0]);
+      LOG_ERROR("GPUPixelContext: warm-up program failed to link {}",
+                messages);
+      ReleaseProgram(compiling.second);
+      warm_up->ok = false;
+      continue;
+    }
+    // Its reference passes to the kept programs
+    warm_programs_.emplace(compiling.first, compiling.second);
+    linked_count++;
+  }
+  LOG_INFO("Warmed up {} program(s)", linked_count);
+  warm_up->promise.set_value(warm_up->ok);
+}
+
+uint32_t GPUPixelContext::TakeWarmProgram(const std::string& sources) {
+  // Programs linked during the warm-up stay with their first user
+  if (warm_up_depth_ > 0 || warm_programs_.empty()) {
+    return 0;
+  }
+  auto it = warm_programs_.find(sources);
+  if (it == warm_programs_.end()) {
+    return 0;
+  }
+  uint32_t program = it->second;
+  warm_programs_.erase(it);
+  return program;
+}
+
+void GPUPixelContext::OnProgramLinked(const std::string& sources,
+                                      uint32_t program) {
+  if (warm_up_depth_ > 0) {
+    RetainProgram(program);
+    warm_programs_.emplace(sources, program);
+  }
+}
+
+uint32_t GPUPixelContext::GetWarmUpStandIn() const {
+  if (warm_up_depth_ == 0 || !warm_up_stand_in_) {
+    return 0;
+  }
+  return warm_up_stand_in_->GetProgram();
+}
+
+void GPUPixelContext::AddCompilingProgram(const std::string& sources,
+                                          uint32_t program) {
+  compiling_programs_.emplace_back(sources, program);
+}
+
+void GPUPixelContext::EnableParallelShaderCompile() {
+  // With KHR_parallel_shader_compile the driver compiles and links on its
+  // own threads, only status and location queries wait
+  if (parallel_shader_compile_checked_) {
+    return;
+  }
+  parallel_shader_compile_checked_ = true;
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+  using MaxThreadsFunc = void(APIENTRY*)(GLuint);
+  MaxThreadsFunc max_threads = nullptr;
+  if (glfwExtensionSupported("GL_KHR_parallel_shader_compile")) {
+    max_threads = reinterpret_cast<MaxThreadsFunc>(
+        glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+  } else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile")) {
+    max_threads = reinterpret_cast<MaxThreadsFunc>(
+        glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+  }
+#elif defined(GPUPIXEL_ANDROID)
+  using MaxThreadsFunc = void(GL_APIENTRY*)(GLuint);
+  MaxThreadsFunc max_threads = nullptr;
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (extensions && strstr(extensions, "GL_KHR_parallel_shader_compile")) {
+    max_threads = reinterpret_cast<MaxThreadsFunc>(
+        eglGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+  }
+#else
+  void (*max_threads)(GLuint) = nullptr;
+#endif
+  if (max_threads) {
+    // As many threads as the driver likes
+    max_threads(0xFFFFFFFF);
+    has_parallel_shader_compile_ = true;
+    LOG_INFO("Parallel shader compile enabled");
+  }
+}
 }  // namespace gpupixel
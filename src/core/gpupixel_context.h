@@ -7,7 +7,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <future>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "core/gpupixel_framebuffer_factory.h"
 #include "gpupixel/filter/filter.h"
 #include "gpupixel/gpupixel_define.h"
@@ -29,6 +34,63 @@ class GPUPIXEL_API GPUPixelContext {
   void Clean();
 
   void SyncRunWithContext(std::function<void(void)> func);
+  // Whether the caller is on the thread SyncRunWithContext() runs tasks on
+  bool IsContextThread() const;
+
+  // For destructors of GL object owners, from any thread without waiting.
+  // The handles are deleted in batches on the GL thread when its current
+  // task ends, or by a queued task if it is idle.
+  void DeleteTexture(uint32_t texture);
+  void DeleteFramebuffer(uint32_t framebuffer);
+  void DeleteBuffer(uint32_t buffer);
+  // A GLsync, where the context has sync objects
+  void DeleteSync(void* sync);
+  // Programs are counted per handle, the last release deletes them.
+  // RetainProgram() is called on the GL thread.
+  void RetainProgram(uint32_t program);
+  void ReleaseProgram(uint32_t program);
+
+  // Runs each of |builds| as its own task on the GL thread, without
+  // blocking the caller. Programs created by a build are only submitted for
+  // compiling and linking, the build itself works on a stand-in program.
+  // Once all builds ran, a task checks the submitted programs, re-queued
+  // until a driver with KHR_parallel_shader_compile has finished them, so
+  // that they compile at once and frames queued meanwhile don't wait. Linked
+  // programs are kept, keyed by their sources, and handed over to the next
+  // program created from the same sources instead of compiling it again.
+  // Each kept program is taken once. The future is false when a build or
+  // link fails or the app is inactive. Not to be waited on from the GL
+  // thread.
+  std::future<bool> WarmUpPrograms(std::vector<std::function<bool()>> builds);
+  // GL thread only. Take returns 0 when there is no kept program.
+  uint32_t TakeWarmProgram(const std::string& sources);
+  void OnProgramLinked(const std::string& sources, uint32_t program);
+  // GL thread only. While a warm-up builds, a program's compile and link
+  // are submitted and its reference handed to AddCompilingProgram(), its
+  // owner gets the stand-in instead. 0 when there is none, the program is
+  // then built as usual.
+  uint32_t GetWarmUpStandIn() const;
+  void AddCompilingProgram(const std::string& sources, uint32_t program);
+
+  // Set on the GL thread while SourceRawData::Prepare() renders its frame.
+  // Only sinks that keep their output inside the graph take part.
+  bool IsPreparingFrame() const { return preparing_frame_; }
+  void SetPreparingFrame(bool preparing) { preparing_frame_ = preparing; }
+
+  // Of the context actually created, e.g. 2 when Android falls back to an
+  // ES 2.0 context, which lacks sized, RG and immutable texture formats and
+  // pixel buffers. 0 without a context.
+  int GetGLMajorVersion() const { return gl_major_version_; }
+  // Capabilities of the context, see the GPUPIXEL_GL_* macros
+  bool HasSyncObjects() const;
+  bool HasPixelBuffers() const;
+  bool HasRGFormats() const;
+  bool HasUnpackRowLength() const;
+  bool HasTextureStorage() const;
+
+  // Whether compute shaders and image load/store can be used, filters with
+  // a compute path fall back to their fragment shader otherwise
+  bool IsComputeSupported();
   void UseAsCurrent(void);
   void PresentBufferForDisplay();
 
@@ -54,6 +116,12 @@ class GPUPIXEL_API GPUPixelContext {
 
   void CreateContext();
   void ReleaseContext();
+  template <typename T>
+  void PostGarbage(std::vector<T>& handles, T handle);
+  void CollectGarbage();
+  void EnableParallelShaderCompile();
+  struct WarmUp;
+  void FinishWarmUp(std::shared_ptr<WarmUp> warm_up);
 
  private:
   static GPUPixelContext* instance_;
@@ -62,6 +130,26 @@ class GPUPIXEL_API GPUPixelContext {
   GPUPixelGLProgram* current_shader_program_;
   std::shared_ptr<DispatchQueue> task_queue_;
 
+  std::mutex garbage_mutex_;
+  std::vector<uint32_t> garbage_textures_;
+  std::vector<uint32_t> garbage_framebuffers_;
+  std::vector<uint32_t> garbage_buffers_;
+  std::vector<uint32_t> garbage_programs_;
+  std::vector<void*> garbage_syncs_;
+  std::atomic<bool> has_garbage_{false};
+  std::atomic<bool> garbage_task_queued_{false};
+  // GL thread only
+  std::unordered_map<uint32_t, int> program_refs_;
+  std::unordered_multimap<std::string, uint32_t> warm_programs_;
+  int warm_up_depth_ = 0;
+  // Of the build running, moved to its warm-up when it returns
+  std::vector<std::pair<std::string, uint32_t>> compiling_programs_;
+  GPUPixelGLProgram* warm_up_stand_in_ = nullptr;
+  bool parallel_shader_compile_checked_ = false;
+  bool has_parallel_shader_compile_ = false;
+  bool preparing_frame_ = false;
+  int gl_major_version_ = 0;
+
 #if defined(GPUPIXEL_IOS)
   EAGLContext* egl_context_;
 #elif defined(GPUPIXEL_MAC)
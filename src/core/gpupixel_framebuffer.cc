@@ -8,9 +8,23 @@
 #include "core/gpupixel_framebuffer.h"
 #include <assert.h>
 #include <algorithm>
+#include <cstring>
 #include "core/gpupixel_context.h"
 #include "utils/util.h"
 
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+#ifndef GL_RGBA16F
+#define GL_RGBA16F 0x881A
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_G
+#define GL_TEXTURE_SWIZZLE_G 0x8E43
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_B
+#define GL_TEXTURE_SWIZZLE_B 0x8E44
+#endif
+
 namespace gpupixel {
 
 #ifndef GPUPIXEL_WIN
@@ -28,6 +42,54 @@ TextureAttributes GPUPixelFramebuffer::default_texture_attributes = {
     GL_RGBA,   GL_RGBA,   GL_UNSIGNED_BYTE};
 #endif
 
+TextureAttributes GPUPixelFramebuffer::GetFormatTextureAttributes(
+    GPUPIXEL_FRAMEBUFFER_FORMAT format) {
+  TextureAttributes attributes = default_texture_attributes;
+  switch (format) {
+#if defined(GPUPIXEL_GL_RG_FORMATS)
+    // RGBA8 stands in for the monochrome formats otherwise
+    case GPUPIXEL_FRAMEBUFFER_FORMAT_R8:
+      if (GPUPixelContext::GetInstance()->HasRGFormats()) {
+        attributes.internalFormat = GL_R8;
+        attributes.format = GL_RED;
+      }
+      break;
+    case GPUPIXEL_FRAMEBUFFER_FORMAT_RG8:
+      if (GPUPixelContext::GetInstance()->HasRGFormats()) {
+        attributes.internalFormat = GL_RG8;
+        attributes.format = GL_RG;
+      }
+      break;
+#endif
+    case GPUPIXEL_FRAMEBUFFER_FORMAT_RGBA16F: {
+#if defined(GPUPIXEL_IOS)
+      // The ES 2.0 context has no sized half float formats
+      static const bool renderable = false;
+#elif defined(GPUPIXEL_GLES_SHADER)
+      // Half float textures are core in GLES 3.0, rendering to them is not
+      static const bool renderable = [] {
+        const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+        return extensions &&
+               (strstr(extensions, "GL_EXT_color_buffer_half_float") ||
+                strstr(extensions, "GL_EXT_color_buffer_float"));
+      }();
+#elif defined(GPUPIXEL_MAC)
+      static const bool renderable = false;
+#else
+      static const bool renderable = true;
+#endif
+      if (renderable) {
+        attributes.internalFormat = GL_RGBA16F;
+        attributes.type = GL_HALF_FLOAT;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return attributes;
+}
+
 GPUPixelFramebuffer::GPUPixelFramebuffer(int width, int height,
     bool only_generate_texture /* = false*/,
     const TextureAttributes texture_attributes)
@@ -44,20 +106,25 @@ GPUPixelFramebuffer::GPUPixelFramebuffer(int width, int height,
   }
 }
 
-GPUPixelFramebuffer::~GPUPixelFramebuffer() {
-  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
-    bool should_delete_texture = (texture_ != -1);
-    bool should_delete_framebuffer = (framebuffer_ != -1);
+GPUPixelFramebuffer::GPUPixelFramebuffer(uint32_t texture,
+                                         int width,
+                                         int height)
+    : width_(width),
+      height_(height),
+      texture_attributes_(default_texture_attributes),
+      has_framebuffer_(false),
+      owns_texture_(false),
+      texture_(texture),
+      framebuffer_(-1) {}
 
-    if (should_delete_texture) {
-      GL_CALL(glDeleteTextures(1, &texture_));
-      texture_ = -1;
-    }
-    if (should_delete_framebuffer) {
-      GL_CALL(glDeleteFramebuffers(1, &framebuffer_));
-      framebuffer_ = -1;
-    }
-  });
+GPUPixelFramebuffer::~GPUPixelFramebuffer() {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  if (owns_texture_ && texture_ != -1) {
+    context->DeleteTexture(texture_);
+  }
+  if (framebuffer_ != -1) {
+    context->DeleteFramebuffer(framebuffer_);
+  }
 }
 
 void GPUPixelFramebuffer::Activate() {
@@ -80,6 +147,12 @@ void GPUPixelFramebuffer::GenerateTexture() {
                           texture_attributes_.wrapS));
   GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
                           texture_attributes_.wrapT));
+#if defined(GPUPIXEL_GL_RG_FORMATS)
+  if (texture_attributes_.format == GL_RED) {
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED));
+  }
+#endif
 
   // TODO: Handle mipmaps
   GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
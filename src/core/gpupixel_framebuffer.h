@@ -29,6 +29,8 @@ class GPUPIXEL_API GPUPixelFramebuffer {
       int height,
       bool only_generate_texture = false,
       const TextureAttributes texture_attributes = default_texture_attributes);
+  // Wraps a texture owned by someone else, it is never deleted here
+  GPUPixelFramebuffer(uint32_t texture, int width, int height);
   ~GPUPixelFramebuffer();
 
   uint32_t GetTexture() const { return texture_; }
@@ -46,12 +48,17 @@ class GPUPIXEL_API GPUPixelFramebuffer {
   void Deactivate();
 
   static TextureAttributes default_texture_attributes;
+  // Attributes for |format|, the default ones where the current context
+  // cannot render to it. Must be called on the GL thread.
+  static TextureAttributes GetFormatTextureAttributes(
+      GPUPIXEL_FRAMEBUFFER_FORMAT format);
 
  private:
   int width_;
   int height_;
   TextureAttributes texture_attributes_;
   bool has_framebuffer_;
+  bool owns_texture_ = true;
   uint32_t texture_;
   uint32_t framebuffer_;
 
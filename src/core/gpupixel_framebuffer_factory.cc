@@ -6,11 +6,30 @@
  */
 
 #include "core/gpupixel_framebuffer_factory.h"
+#include <algorithm>
+#include <list>
+#include <mutex>
 #include "utils/util.h"
 
 namespace gpupixel {
 
-FramebufferFactory::FramebufferFactory() {}
+struct FramebufferFactory::Pool {
+  std::mutex mutex;
+  // Idle framebuffers and their keys, the most recently returned last
+  std::list<std::pair<std::string, std::unique_ptr<GPUPixelFramebuffer>>>
+      idle;
+  int64_t idle_texels = 0;
+  int64_t used_texels = 0;
+  int64_t peak_texels = 0;
+};
+
+namespace {
+int64_t Texels(const GPUPixelFramebuffer& framebuffer) {
+  return (int64_t)framebuffer.GetWidth() * framebuffer.GetHeight();
+}
+}  // namespace
+
+FramebufferFactory::FramebufferFactory() : pool_(std::make_shared<Pool>()) {}
 
 FramebufferFactory::~FramebufferFactory() {
   Clean();
@@ -21,36 +40,64 @@ std::shared_ptr<GPUPixelFramebuffer> FramebufferFactory::CreateFramebuffer(
     int height,
     bool only_texture /* = false*/,
     const TextureAttributes texture_attributes /* = defaultTextureAttribure*/) {
-  std::shared_ptr<GPUPixelFramebuffer> framebuffer_from_cache;
-  std::string lookup_hash = GenerateUuid(width, height, only_texture, texture_attributes);
-  int number_of_matching_framebuffers = 0;
-  auto itc = framebuffer_type_counts_.find(lookup_hash);
-  if (itc != framebuffer_type_counts_.end()) {
-    number_of_matching_framebuffers = itc->second;
-  }
-  
-  if (number_of_matching_framebuffers > 0) {
-    int cur_framebuffer_id = number_of_matching_framebuffers - 1;
-    while (!framebuffer_from_cache && cur_framebuffer_id >= 0) {
-      auto it = framebuffers_.find(Util::StringFormat("%s-%ld", lookup_hash.c_str(), cur_framebuffer_id));
-      if (it != framebuffers_.end()) {
-        framebuffer_from_cache = it->second;
-        framebuffers_.erase(it);
-      } else {
-        framebuffer_from_cache = 0;
+  std::string lookup_hash =
+      GenerateUuid(width, height, only_texture, texture_attributes);
+  std::unique_ptr<GPUPixelFramebuffer> framebuffer;
+  {
+    std::unique_lock<std::mutex> lock(pool_->mutex);
+    for (auto it = pool_->idle.rbegin(); it != pool_->idle.rend(); ++it) {
+      if (it->first == lookup_hash) {
+        framebuffer = std::move(it->second);
+        pool_->idle_texels -= Texels(*framebuffer);
+        pool_->idle.erase(std::next(it).base());
+        break;
       }
-      cur_framebuffer_id--;
     }
-    cur_framebuffer_id++;
-    framebuffer_type_counts_[lookup_hash] = cur_framebuffer_id;
+    pool_->used_texels += (int64_t)width * height;
+    pool_->peak_texels = std::max(pool_->peak_texels, pool_->used_texels);
   }
 
-  if (!framebuffer_from_cache) {
-    framebuffer_from_cache = std::make_shared<GPUPixelFramebuffer>(
-            width, height, only_texture, texture_attributes);
+  if (!framebuffer) {
+    framebuffer.reset(new GPUPixelFramebuffer(width, height, only_texture,
+                                              texture_attributes));
   }
 
-  return framebuffer_from_cache;
+  std::weak_ptr<Pool> weak_pool = pool_;
+  return std::shared_ptr<GPUPixelFramebuffer>(
+      framebuffer.release(),
+      [weak_pool, lookup_hash](GPUPixelFramebuffer* released) {
+        // Declared before the lock, evicted framebuffers are deleted after
+        std::unique_ptr<GPUPixelFramebuffer> owned(released);
+        std::list<
+            std::pair<std::string, std::unique_ptr<GPUPixelFramebuffer>>>
+            evicted;
+        auto pool = weak_pool.lock();
+        if (!pool) {
+          return;
+        }
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->used_texels -= Texels(*owned);
+        if (pool->used_texels == 0) {
+          // The graph is gone, and with it the sizes worth keeping
+          evicted.swap(pool->idle);
+          pool->idle_texels = 0;
+          pool->peak_texels = 0;
+          return;
+        }
+        pool->idle_texels += Texels(*owned);
+        pool->idle.emplace_back(lookup_hash, std::move(owned));
+        while (pool->idle_texels > pool->peak_texels) {
+          pool->idle_texels -= Texels(*pool->idle.front().second);
+          evicted.splice(evicted.end(), pool->idle, pool->idle.begin());
+        }
+      });
+}
+
+std::shared_ptr<GPUPixelFramebuffer>
+FramebufferFactory::CreateFramebufferWithTexture(uint32_t texture,
+                                                 int width,
+                                                 int height) {
+  return std::make_shared<GPUPixelFramebuffer>(texture, width, height);
 }
 
 std::string FramebufferFactory::GenerateUuid(
@@ -75,14 +122,13 @@ std::string FramebufferFactory::GenerateUuid(
   }
 }
 
-std::shared_ptr<GPUPixelFramebuffer> FramebufferFactory::GetFramebufferByUuid(
-    const std::string& hash) {
-  return framebuffers_[hash];
-}
-
 void FramebufferFactory::Clean() {
-  framebuffers_.clear();
-  framebuffer_type_counts_.clear();
+  std::list<std::pair<std::string, std::unique_ptr<GPUPixelFramebuffer>>>
+      idle;
+  std::unique_lock<std::mutex> lock(pool_->mutex);
+  idle.swap(pool_->idle);
+  pool_->idle_texels = 0;
+  pool_->peak_texels = pool_->used_texels;
 }
 
 }  // namespace gpupixel
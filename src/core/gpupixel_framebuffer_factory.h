@@ -7,12 +7,17 @@
 
 #pragma once
 
-#include <map>
+#include <memory>
 #include <string>
 #include "core/gpupixel_framebuffer.h"
 #include "gpupixel/gpupixel_define.h"
 
 namespace gpupixel {
+// Framebuffers from CreateFramebuffer() return to an idle pool when their
+// last reference is dropped, on any thread, and are handed out again for
+// the same size and attributes. The pool keeps at most as many texels as
+// were in use at the peak, enough to switch back and forth between two
+// sizes without allocating, and is emptied when nothing is in use.
 class GPUPIXEL_API FramebufferFactory {
  public:
   FramebufferFactory();
@@ -24,18 +29,27 @@ class GPUPIXEL_API FramebufferFactory {
       const TextureAttributes texture_attributes =
           GPUPixelFramebuffer::default_texture_attributes);
 
+  // Wraps a texture from the caller or a shared context. Such framebuffers
+  // are never pooled and are untouched by Clean(), the texture's owner must
+  // keep it alive until the returned framebuffer is released.
+  std::shared_ptr<GPUPixelFramebuffer> CreateFramebufferWithTexture(
+      uint32_t texture,
+      int width,
+      int height);
+
+  // Releases the idle framebuffers
   void Clean();
 
  private:
+  struct Pool;
+
   std::string GenerateUuid(int width,
                            int height,
                            bool only_texture,
                            const TextureAttributes texture_attributes) const;
-  std::shared_ptr<GPUPixelFramebuffer> GetFramebufferByUuid(
-      const std::string& hash);
 
-  std::map<std::string, std::shared_ptr<GPUPixelFramebuffer>> framebuffers_;
-  std::map<std::string, int> framebuffer_type_counts_;
+  // Shared with the deleters of handed out framebuffers
+  std::shared_ptr<Pool> pool_;
 };
 
 }  // namespace gpupixel
@@ -0,0 +1,62 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "core/gpupixel_gl_compute.h"
+
+#ifndef GL_MAJOR_VERSION
+#define GL_MAJOR_VERSION 0x821B
+#endif
+#ifndef GL_MINOR_VERSION
+#define GL_MINOR_VERSION 0x821C
+#endif
+
+namespace gpupixel {
+
+namespace {
+bool LoadGLComputeFunctions(GLComputeFunctions& functions) {
+#if defined(GPUPIXEL_GL_COMPUTE)
+  // Image load/store on GLES 3.1 needs immutable textures, which our
+  // framebuffers are not, so compute is limited to desktop GL 4.3+
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major < 4 || (major == 4 && minor < 3)) {
+    LOG_INFO("GL {}.{} has no compute shaders, using fragment filters", major,
+             minor);
+    return false;
+  }
+
+  functions.dispatch_compute =
+      reinterpret_cast<decltype(functions.dispatch_compute)>(
+          glfwGetProcAddress("glDispatchCompute"));
+  functions.bind_image_texture =
+      reinterpret_cast<decltype(functions.bind_image_texture)>(
+          glfwGetProcAddress("glBindImageTexture"));
+  functions.memory_barrier =
+      reinterpret_cast<decltype(functions.memory_barrier)>(
+          glfwGetProcAddress("glMemoryBarrier"));
+  if (!functions.dispatch_compute || !functions.bind_image_texture ||
+      !functions.memory_barrier) {
+    LOG_WARN("GL {}.{} is missing compute entry points", major, minor);
+    return false;
+  }
+  LOG_INFO("GL {}.{} compute shaders enabled", major, minor);
+  return true;
+#else
+  return false;
+#endif
+}
+}  // namespace
+
+const GLComputeFunctions* GetGLComputeFunctions() {
+  static GLComputeFunctions functions;
+  static bool supported = LoadGLComputeFunctions(functions);
+  return supported ? &functions : nullptr;
+}
+
+}  // namespace gpupixel
@@ -0,0 +1,64 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include "core/gpupixel_gl_include.h"
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_FRAMEBUFFER_BARRIER_BIT
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace gpupixel {
+
+// Compute entry points resolved at runtime, the bundled loader only covers
+// GL 3.2 and the GLES headers we build against stop at 3.0.
+struct GLComputeFunctions {
+  void(APIENTRY* dispatch_compute)(GLuint num_groups_x,
+                                   GLuint num_groups_y,
+                                   GLuint num_groups_z);
+  void(APIENTRY* bind_image_texture)(GLuint unit,
+                                     GLuint texture,
+                                     GLint level,
+                                     GLboolean layered,
+                                     GLint layer,
+                                     GLenum access,
+                                     GLenum format);
+  void(APIENTRY* memory_barrier)(GLbitfield barriers);
+};
+
+// Returns null when the current context has no usable compute support.
+// Must be called on the GL thread, the result is cached after the first
+// call.
+const GLComputeFunctions* GetGLComputeFunctions();
+
+}  // namespace gpupixel
@@ -18,6 +18,7 @@
 #import <OpenGL/gl.h>
 #elif defined(GPUPIXEL_ANDROID)
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES/gl.h>
 #include <GLES/glext.h>
 #include <GLES3/gl3.h>
@@ -36,6 +37,33 @@
 #include <emscripten/html5.h>
 #endif
 
+// GL 3.x / GLES 3.0 features by the platforms whose headers declare them.
+// The legacy macOS profile has few of them, iOS runs an ES 2.0 context and
+// WebGL lacks buffer mapping. Code using one is compiled under its macro and
+// checks the matching GPUPixelContext query at run time, which is false on
+// e.g. an Android ES 2.0 fallback context.
+#if !defined(GPUPIXEL_MAC) && !defined(GPUPIXEL_IOS)
+#define GPUPIXEL_GL_SYNC_OBJECTS
+#endif
+#if !defined(GPUPIXEL_IOS)
+#define GPUPIXEL_GL_UNPACK_ROW_LENGTH
+#endif
+#if !defined(GPUPIXEL_MAC) && !defined(GPUPIXEL_IOS) && \
+    !defined(GPUPIXEL_WASM)
+// Pixel pack and unpack buffers with glMapBufferRange
+#define GPUPIXEL_GL_PIXEL_BUFFERS
+// R8 and RG8 textures with swizzles
+#define GPUPIXEL_GL_RG_FORMATS
+#endif
+#if defined(GPUPIXEL_ANDROID) || defined(GPUPIXEL_WASM)
+// glTexStorage2D, the desktop loader stops before GL 4.2
+#define GPUPIXEL_GL_TEXTURE_STORAGE
+#endif
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+// Loaded at run time, see gpupixel_gl_compute.cc
+#define GPUPIXEL_GL_COMPUTE
+#endif
+
 // clang-format off
 //------------- ENABLE_GL_CHECK Begin ------------ //
 #if defined(NDEBUG)
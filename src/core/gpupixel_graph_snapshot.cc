@@ -0,0 +1,160 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "core/gpupixel_graph_snapshot.h"
+#include <atomic>
+#include <mutex>
+
+namespace gpupixel {
+
+namespace {
+// Serializes writers, the render thread only loads Published(). Both are
+// leaked, nodes may be destroyed by static destructors.
+std::mutex& EditMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
+}
+
+std::shared_ptr<const GraphSnapshot>* Published() {
+  static auto* published = new std::shared_ptr<const GraphSnapshot>(
+      std::make_shared<GraphSnapshot>());
+  return published;
+}
+
+// Edits of the open batch, replayed onto the latest snapshot when it ends
+// so that edits other threads published meanwhile are kept. No lock is
+// held in between, a batch may create nodes on the GL thread.
+thread_local int edit_depth = 0;
+thread_local std::vector<std::function<void(GraphSnapshot&)>> batch;
+// What the batch's thread sees: |batch_base| with the edits applied so far,
+// updated in place by each edit unless Current() handed it out meanwhile
+thread_local std::shared_ptr<GraphSnapshot> batch_snapshot;
+thread_local std::shared_ptr<const GraphSnapshot> batch_base;
+thread_local int frame_depth = 0;
+thread_local std::shared_ptr<const GraphSnapshot> pinned;
+
+std::shared_ptr<GraphSnapshot> CopyWithBatch() {
+  auto next = std::make_shared<GraphSnapshot>(*std::atomic_load(Published()));
+  for (auto& edit : batch) {
+    edit(*next);
+  }
+  return next;
+}
+
+// Replaced snapshots go to |retired|, to be released after the lock as they
+// may hold the last references to removed nodes
+void Publish(std::shared_ptr<const GraphSnapshot> next,
+             std::shared_ptr<const GraphSnapshot> retired[2]) {
+  if (frame_depth > 0) {
+    retired[1] = pinned;
+    pinned = next;
+  }
+  retired[0] = std::atomic_exchange(Published(), next);
+}
+}  // namespace
+
+std::shared_ptr<const GraphSnapshot> GraphSnapshot::Current() {
+  if (batch_snapshot) {
+    return batch_snapshot;
+  }
+  if (frame_depth > 0) {
+    return pinned;
+  }
+  return std::atomic_load(Published());
+}
+
+void GraphSnapshot::Edit(std::function<void(GraphSnapshot&)> edit) {
+  if (edit_depth > 0) {
+    batch.push_back(edit);
+    if (!batch_snapshot) {
+      batch_base = std::atomic_load(Published());
+      batch_snapshot = std::make_shared<GraphSnapshot>(*batch_base);
+    } else if (batch_snapshot.use_count() > 1) {
+      batch_snapshot = std::make_shared<GraphSnapshot>(*batch_snapshot);
+    }
+    edit(*batch_snapshot);
+    return;
+  }
+  std::shared_ptr<const GraphSnapshot> retired[2];
+  {
+    std::lock_guard<std::mutex> lock(EditMutex());
+    auto next = std::make_shared<GraphSnapshot>(*std::atomic_load(Published()));
+    edit(*next);
+    Publish(next, retired);
+  }
+}
+
+void GraphSnapshot::BeginEdit() {
+  edit_depth++;
+}
+
+void GraphSnapshot::EndEdit() {
+  if (--edit_depth > 0 || batch.empty()) {
+    return;
+  }
+  std::shared_ptr<const GraphSnapshot> retired[2];
+  {
+    std::lock_guard<std::mutex> lock(EditMutex());
+    // Replayed only when another thread published in between
+    if (std::atomic_load(Published()) == batch_base) {
+      Publish(batch_snapshot, retired);
+    } else {
+      Publish(CopyWithBatch(), retired);
+    }
+  }
+  batch.clear();
+  batch_snapshot.reset();
+  batch_base.reset();
+}
+
+GraphSnapshot::FrameScope::FrameScope() {
+  if (frame_depth++ == 0) {
+    pinned = std::atomic_load(Published());
+  }
+}
+
+GraphSnapshot::FrameScope::~FrameScope() {
+  if (--frame_depth == 0) {
+    pinned.reset();
+  }
+}
+
+std::shared_ptr<const GraphSnapshot::SinkMap> GraphSnapshot::GetSinks(
+    const Source* source) const {
+  static const std::shared_ptr<const SinkMap> empty =
+      std::make_shared<SinkMap>();
+  auto it = sinks_.find(source);
+  return it != sinks_.end() ? it->second : empty;
+}
+
+std::shared_ptr<const GraphSnapshot::FilterList> GraphSnapshot::GetFilters(
+    const FilterGroup* group) const {
+  static const std::shared_ptr<const FilterList> empty =
+      std::make_shared<FilterList>();
+  auto it = filters_.find(group);
+  return it != filters_.end() ? it->second : empty;
+}
+
+void GraphSnapshot::SetSinks(const Source* source,
+                             std::shared_ptr<const SinkMap> sinks) {
+  if (sinks && !sinks->empty()) {
+    sinks_[source] = sinks;
+  } else {
+    sinks_.erase(source);
+  }
+}
+
+void GraphSnapshot::SetFilters(const FilterGroup* group,
+                               std::shared_ptr<const FilterList> filters) {
+  if (filters && !filters->empty()) {
+    filters_[group] = filters;
+  } else {
+    filters_.erase(group);
+  }
+}
+
+}  // namespace gpupixel
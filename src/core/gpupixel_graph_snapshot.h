@@ -0,0 +1,75 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gpupixel {
+class Filter;
+class FilterGroup;
+class Sink;
+class Source;
+
+// Immutable copy of the graph's edges: the sinks of every source and the
+// members of every filter group.
+//
+// Edits copy the latest snapshot, change the copy and publish it with one
+// atomic exchange. Writers serialize among themselves, the render thread
+// never takes their lock. It pins the latest snapshot when a frame starts and
+// works from it until the frame ends, so an edit, or a GraphEdit batch of
+// them, is seen entirely or not at all. Nodes an edit drops stay alive
+// until the last snapshot referencing them is released.
+class GraphSnapshot {
+ public:
+  using SinkMap = std::map<std::shared_ptr<Sink>, int>;
+  using FilterList = std::vector<std::shared_ptr<Filter>>;
+
+  // What the calling thread sees: the snapshot the open batch started from
+  // with its edits applied, the pinned snapshot during a frame, the latest
+  // published one otherwise
+  static std::shared_ptr<const GraphSnapshot> Current();
+
+  // Runs |edit| on a copy of the latest snapshot and publishes it. Inside a
+  // GraphEdit the edit is kept and run again when the batch ends, so it
+  // must capture by value and work relative to the snapshot it is given.
+  static void Edit(std::function<void(GraphSnapshot&)> edit);
+
+  static void BeginEdit();
+  static void EndEdit();
+
+  // Pins a snapshot for the outermost scope on the render thread. Edits the
+  // render thread makes itself are visible at once.
+  class FrameScope {
+   public:
+    FrameScope();
+    ~FrameScope();
+    FrameScope(const FrameScope&) = delete;
+    FrameScope& operator=(const FrameScope&) = delete;
+  };
+
+  // Never null, empty for unknown nodes
+  std::shared_ptr<const SinkMap> GetSinks(const Source* source) const;
+  std::shared_ptr<const FilterList> GetFilters(const FilterGroup* group) const;
+
+  // Null drops the entry, for nodes being destroyed
+  void SetSinks(const Source* source, std::shared_ptr<const SinkMap> sinks);
+  void SetFilters(const FilterGroup* group,
+                  std::shared_ptr<const FilterList> filters);
+
+ private:
+  // Keyed by address, nodes remove themselves on destruction
+  std::unordered_map<const Source*, std::shared_ptr<const SinkMap>> sinks_;
+  std::unordered_map<const FilterGroup*, std::shared_ptr<const FilterList>>
+      filters_;
+};
+
+}  // namespace gpupixel
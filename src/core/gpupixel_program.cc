@@ -6,42 +6,18 @@
  */
 
 #include "core/gpupixel_program.h"
-#include <algorithm>
 #include "core/gpupixel_context.h"
+#include "core/gpupixel_gl_compute.h"
 #include "utils/util.h"
 
 namespace gpupixel {
 
-std::vector<GPUPixelGLProgram*> GPUPixelGLProgram::programs_;
-
-GPUPixelGLProgram::GPUPixelGLProgram() : program_(-1) {
-  programs_.push_back(this);
-}
+GPUPixelGLProgram::GPUPixelGLProgram() : program_(0) {}
 
 GPUPixelGLProgram::~GPUPixelGLProgram() {
-  GPUPixelContext::GetInstance()->SyncRunWithContext([=] {
-    std::vector<GPUPixelGLProgram*>::iterator itr =
-        std::find(programs_.begin(), programs_.end(), this);
-    if (itr != programs_.end()) {
-      programs_.erase(itr);
-    }
-
-    bool should_delete_program = (program_ != -1);
-
-    for (auto const& program : programs_) {
-      if (should_delete_program) {
-        if (program_ == program->GetProgram()) {
-          should_delete_program = false;
-          break;
-        }
-      }
-    }
-
-    if (should_delete_program) {
-      glDeleteProgram(program_);
-      program_ = -1;
-    }
-  });
+  if (program_ != 0) {
+    GPUPixelContext::GetInstance()->ReleaseProgram(program_);
+  }
 }
 
 GPUPixelGLProgram* GPUPixelGLProgram::CreateWithShaderString(
@@ -61,65 +37,165 @@ GPUPixelGLProgram* GPUPixelGLProgram::CreateWithShaderString(
 bool GPUPixelGLProgram::InitWithShaderString(
     const std::string& vertex_shader_source,
     const std::string& fragment_shader_source) {
-  if (program_ != -1) {
-    GL_CALL(glDeleteProgram(program_));
-    program_ = -1;
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  if (program_ != 0) {
+    context->ReleaseProgram(program_);
+    program_ = 0;
+  }
+  const std::string sources =
+      vertex_shader_source + '\0' + fragment_shader_source;
+  if (uint32_t warm_program = context->TakeWarmProgram(sources)) {
+    // Its reference passes to us
+    program_ = warm_program;
+    return true;
   }
   GL_CALL(program_ = glCreateProgram());
+  context->RetainProgram(program_);
 
+  // Compiled and linked before any status is read, each query waits for a
+  // driver compiling in parallel. Only a failed link asks which stage broke.
   uint32_t vert_shader;
   GL_CALL(vert_shader = glCreateShader(GL_VERTEX_SHADER));
   const char* vertex_shader_source_str = vertex_shader_source.c_str();
   GL_CALL(glShaderSource(vert_shader, 1, &vertex_shader_source_str, NULL));
   GL_CALL(glCompileShader(vert_shader));
 
-  //
-  GLint compile_success;
-  glGetShaderiv(vert_shader, GL_COMPILE_STATUS, &compile_success);
-  if (compile_success == GL_FALSE) {
-    GLchar messages[256];
-    glGetShaderInfoLog(vert_shader, sizeof(messages), 0, &messages[0]);
-#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
-    NSString* message_string = [NSString stringWithUTF8String:messages];
-    NSLog(@"%@", message_string);
-#else
-
-#endif
-    LOG_ERROR(
-        "GL ERROR GPUPixelGLProgram::InitWithShaderString vertex shader {}",
-        messages);
-    return -1;
-  }
-
   uint32_t frag_shader;
   GL_CALL(frag_shader = glCreateShader(GL_FRAGMENT_SHADER));
   const char* fragment_shader_source_str = fragment_shader_source.c_str();
   GL_CALL(glShaderSource(frag_shader, 1, &fragment_shader_source_str, NULL));
   GL_CALL(glCompileShader(frag_shader));
 
-  glGetShaderiv(frag_shader, GL_COMPILE_STATUS, &compile_success);
-  if (compile_success == GL_FALSE) {
-    GLchar messages[256];
-    glGetShaderInfoLog(frag_shader, sizeof(messages), 0, &messages[0]);
+  GL_CALL(glAttachShader(program_, vert_shader));
+  GL_CALL(glAttachShader(program_, frag_shader));
+
+  GL_CALL(glLinkProgram(program_));
+
+  if (uint32_t stand_in = context->GetWarmUpStandIn()) {
+    // Checked by the warm-up along with the programs submitted after it,
+    // the filter being built only queries locations
+    GL_CALL(glDeleteShader(vert_shader));
+    GL_CALL(glDeleteShader(frag_shader));
+    context->AddCompilingProgram(sources, program_);
+    program_ = stand_in;
+    context->RetainProgram(program_);
+    return true;
+  }
+
+  GLint link_success;
+  glGetProgramiv(program_, GL_LINK_STATUS, &link_success);
+  if (link_success == GL_FALSE) {
+    GLint compile_success;
+    glGetShaderiv(vert_shader, GL_COMPILE_STATUS, &compile_success);
+    if (compile_success == GL_FALSE) {
+      GLchar messages[256];
+      glGetShaderInfoLog(vert_shader, sizeof(messages), 0, &messages[0]);
 #if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
-    NSString* message_string = [NSString stringWithUTF8String:messages];
-    NSLog(@"%@", message_string);
+      NSString* message_string = [NSString stringWithUTF8String:messages];
+      NSLog(@"%@", message_string);
 #else
 
 #endif
-    LOG_ERROR("GL ERROR GPUPixelGLProgram::InitWithShaderString frag shader {}",
-              messages);
-    return -1;
-  }
+      LOG_ERROR(
+          "GL ERROR GPUPixelGLProgram::InitWithShaderString vertex shader {}",
+          messages);
+      GL_CALL(glDeleteShader(vert_shader));
+      GL_CALL(glDeleteShader(frag_shader));
+      return false;
+    }
 
-  GL_CALL(glAttachShader(program_, vert_shader));
-  GL_CALL(glAttachShader(program_, frag_shader));
+    glGetShaderiv(frag_shader, GL_COMPILE_STATUS, &compile_success);
+    if (compile_success == GL_FALSE) {
+      GLchar messages[256];
+      glGetShaderInfoLog(frag_shader, sizeof(messages), 0, &messages[0]);
+#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
+      NSString* message_string = [NSString stringWithUTF8String:messages];
+      NSLog(@"%@", message_string);
+#else
 
-  GL_CALL(glLinkProgram(program_));
+#endif
+      LOG_ERROR(
+          "GL ERROR GPUPixelGLProgram::InitWithShaderString frag shader {}",
+          messages);
+      GL_CALL(glDeleteShader(vert_shader));
+      GL_CALL(glDeleteShader(frag_shader));
+      return false;
+    }
+
+    GLchar messages[256];
+    glGetProgramInfoLog(program_, sizeof(messages), 0, &messages[0]);
+    LOG_ERROR("GL ERROR GPUPixelGLProgram::InitWithShaderString link {}",
+              messages);
+    GL_CALL(glDeleteShader(vert_shader));
+    GL_CALL(glDeleteShader(frag_shader));
+    return false;
+  }
 
   GL_CALL(glDeleteShader(vert_shader));
   GL_CALL(glDeleteShader(frag_shader));
 
+  context->OnProgramLinked(sources, program_);
+  return true;
+}
+
+GPUPixelGLProgram* GPUPixelGLProgram::CreateWithComputeShaderString(
+    const std::string& compute_shader_source) {
+  GPUPixelGLProgram* ret = new (std::nothrow) GPUPixelGLProgram();
+  if (ret) {
+    if (!ret->InitWithComputeShaderString(compute_shader_source)) {
+      delete ret;
+      ret = nullptr;
+    }
+  }
+  return ret;
+}
+
+bool GPUPixelGLProgram::InitWithComputeShaderString(
+    const std::string& compute_shader_source) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  if (program_ != 0) {
+    context->ReleaseProgram(program_);
+    program_ = 0;
+  }
+  // Can't be mistaken for a vertex and fragment pair, which has a separator
+  const std::string& sources = compute_shader_source;
+  if (uint32_t warm_program = context->TakeWarmProgram(sources)) {
+    program_ = warm_program;
+    return true;
+  }
+  GL_CALL(program_ = glCreateProgram());
+  context->RetainProgram(program_);
+
+  uint32_t compute_shader;
+  GL_CALL(compute_shader = glCreateShader(GL_COMPUTE_SHADER));
+  const char* compute_shader_source_str = compute_shader_source.c_str();
+  GL_CALL(glShaderSource(compute_shader, 1, &compute_shader_source_str, NULL));
+  GL_CALL(glCompileShader(compute_shader));
+
+  GLint compile_success;
+  glGetShaderiv(compute_shader, GL_COMPILE_STATUS, &compile_success);
+  if (compile_success == GL_FALSE) {
+    GLchar messages[256];
+    glGetShaderInfoLog(compute_shader, sizeof(messages), 0, &messages[0]);
+    LOG_ERROR(
+        "GL ERROR GPUPixelGLProgram::InitWithComputeShaderString compute "
+        "shader {}",
+        messages);
+    GL_CALL(glDeleteShader(compute_shader));
+    return false;
+  }
+
+  GL_CALL(glAttachShader(program_, compute_shader));
+  GL_CALL(glLinkProgram(program_));
+  GL_CALL(glDeleteShader(compute_shader));
+
+  GLint link_success;
+  glGetProgramiv(program_, GL_LINK_STATUS, &link_success);
+  if (link_success == GL_FALSE) {
+    LOG_ERROR("GL ERROR GPUPixelGLProgram::InitWithComputeShaderString link");
+    return false;
+  }
+  context->OnProgramLinked(sources, program_);
   return true;
 }
 
@@ -205,4 +281,30 @@ void GPUPixelGLProgram::SetUniformValue(int uniform_location,
   GL_CALL(glUniform1fv(uniform_location, length, (float*)value));
 }
 
+void GPUPixelGLProgram::SetUniformArray(const std::string& uniform_name,
+                                        const float* values,
+                                        int components,
+                                        int count) {
+  GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
+  int location = GetUniformLocation(uniform_name);
+  switch (components) {
+    case 1:
+      GL_CALL(glUniform1fv(location, count, values));
+      break;
+    case 2:
+      GL_CALL(glUniform2fv(location, count, values));
+      break;
+    case 3:
+      GL_CALL(glUniform3fv(location, count, values));
+      break;
+    case 4:
+      GL_CALL(glUniform4fv(location, count, values));
+      break;
+    default:
+      LOG_ERROR("GPUPixelGLProgram::SetUniformArray invalid components {}",
+                components);
+      break;
+  }
+}
+
 }  // namespace gpupixel
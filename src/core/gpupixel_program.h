@@ -21,6 +21,10 @@ class GPUPIXEL_API GPUPixelGLProgram {
   static GPUPixelGLProgram* CreateWithShaderString(
       const std::string& vertex_shader_source,
       const std::string& fragment_shader_source);
+  // Needs a context with compute support, see
+  // GPUPixelContext::IsComputeSupported()
+  static GPUPixelGLProgram* CreateWithComputeShaderString(
+      const std::string& compute_shader_source);
   void UseProgram();
   uint32_t GetProgram() const { return program_; }
 
@@ -44,11 +48,19 @@ class GPUPIXEL_API GPUPixelGLProgram {
   void SetUniformValue(int uniform_location, Matrix4 value);
   void SetUniformValue(int uniform_location, const void* array, int length);
 
+  // Upload |count| vec|components| elements, e.g. a vec4 array
+  void SetUniformArray(const std::string& uniform_name,
+                       const float* values,
+                       int components,
+                       int count);
+
  private:
-  static std::vector<GPUPixelGLProgram*> programs_;
+  // Counted by the context, which deletes it once released everywhere. 0
+  // until created.
   uint32_t program_;
   bool InitWithShaderString(const std::string& vertex_shader_source,
                             const std::string& fragment_shader_source);
+  bool InitWithComputeShaderString(const std::string& compute_shader_source);
 };
 
 }  // namespace gpupixel
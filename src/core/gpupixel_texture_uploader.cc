@@ -0,0 +1,244 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "core/gpupixel_texture_uploader.h"
+#include <cstring>
+#include "core/gpupixel_context.h"
+
+namespace gpupixel {
+
+GPUPixelTextureUploader::GPUPixelTextureUploader(int channels)
+    : channels_(channels) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  has_pixel_buffers_ = context->HasPixelBuffers();
+  has_texture_storage_ = context->HasTextureStorage();
+  has_unpack_row_length_ = context->HasUnpackRowLength();
+#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
+  static const GLenum internal_formats[] = {GL_LUMINANCE, GL_LUMINANCE_ALPHA,
+                                            GL_RGB, GL_RGBA};
+  static const GLenum formats[] = {GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB,
+                                   GL_RGBA};
+#elif defined(GPUPIXEL_GL_TEXTURE_STORAGE)
+  static const GLenum internal_formats[] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+  static const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+#else
+  static const GLenum internal_formats[] = {GL_R8, GL_RG8, GL_RGB, GL_RGBA};
+  static const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+#endif
+  internal_format_ = internal_formats[channels - 1];
+  format_ = formats[channels - 1];
+#if defined(GPUPIXEL_GL_TEXTURE_STORAGE)
+  // Devices without GLES 3.0 get an ES 2.0 context, the formats of iOS and
+  // plain texture uploads
+  if (!has_texture_storage_) {
+    static const GLenum legacy_formats[] = {GL_LUMINANCE, GL_LUMINANCE_ALPHA,
+                                            GL_RGB, GL_RGBA};
+    internal_format_ = legacy_formats[channels - 1];
+    format_ = legacy_formats[channels - 1];
+  }
+#endif
+}
+
+GPUPixelTextureUploader::~GPUPixelTextureUploader() {
+  // Deleting a mapped buffer unmaps it, nothing here needs the GL thread
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  for (GLuint buffer : buffers_) {
+    if (buffer) {
+      context->DeleteBuffer(buffer);
+    }
+  }
+  if (texture_) {
+    context->DeleteTexture(texture_);
+  }
+}
+
+void GPUPixelTextureUploader::Allocate(int width, int height) {
+  width_ = width;
+  height_ = height;
+
+#if defined(GPUPIXEL_GL_TEXTURE_STORAGE)
+  // Immutable storage can't be resized, start over with a new texture
+  if (texture_ && has_texture_storage_) {
+    GL_CALL(glDeleteTextures(1, &texture_));
+    texture_ = 0;
+  }
+#endif
+  if (!texture_) {
+    GL_CALL(glGenTextures(1, &texture_));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    GL_CALL(
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+  }
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_));
+#if defined(GPUPIXEL_GL_TEXTURE_STORAGE)
+  if (has_texture_storage_) {
+    GL_CALL(glTexStorage2D(GL_TEXTURE_2D, 1, internal_format_, width, height));
+  } else {
+    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, internal_format_, width, height, 0,
+                         format_, GL_UNSIGNED_BYTE, nullptr));
+  }
+#else
+  GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, internal_format_, width, height, 0,
+                       format_, GL_UNSIGNED_BYTE, nullptr));
+#endif
+
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  std::unique_lock<std::mutex> lock(mutex_);
+  ReleaseBuffers();
+  if (!has_pixel_buffers_) {
+    return;
+  }
+  GL_CALL(glGenBuffers(kRingSize, buffers_));
+  for (GLuint buffer : buffers_) {
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer));
+    GL_CALL(glBufferData(GL_PIXEL_UNPACK_BUFFER, width * height * channels_,
+                         nullptr, GL_STREAM_DRAW));
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+  current_ = 0;
+#endif
+}
+
+void GPUPixelTextureUploader::CopyRows(uint8_t* dst,
+                                       const uint8_t* src,
+                                       int stride) const {
+  int row_size = width_ * channels_;
+  if (stride == row_size) {
+    std::memcpy(dst, src, row_size * height_);
+    return;
+  }
+  for (int y = 0; y < height_; ++y) {
+    std::memcpy(dst + y * row_size, src + y * stride, row_size);
+  }
+}
+
+bool GPUPixelTextureUploader::Stage(const uint8_t* pixels,
+                                    int width,
+                                    int height,
+                                    int stride) {
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!mapped_ || width != width_ || height != height_) {
+    return false;
+  }
+  CopyRows(mapped_, pixels, stride ? stride : width * channels_);
+  staged_ = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void GPUPixelTextureUploader::Upload(const uint8_t* pixels,
+                                     int width,
+                                     int height,
+                                     int stride,
+                                     GLenum format) {
+  if (!texture_ || width != width_ || height != height_) {
+    Allocate(width, height);
+  }
+  if (stride == 0) {
+    stride = width * channels_;
+  }
+  if (format == 0) {
+    format = format_;
+  }
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_));
+
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!buffers_[0]) {
+    lock.unlock();
+    UploadFromMemory(pixels, stride, format);
+    return;
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[current_]));
+  if (!mapped_) {
+    mapped_ = (uint8_t*)glMapBufferRange(
+        GL_PIXEL_UNPACK_BUFFER, 0, width * height * channels_,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  }
+  if (mapped_) {
+    if (!staged_) {
+      CopyRows(mapped_, pixels, stride);
+    }
+    mapped_ = nullptr;
+    staged_ = false;
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+      GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format,
+                              GL_UNSIGNED_BYTE, nullptr));
+      GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+      MapNextBuffer();
+      return;
+    }
+    // The buffer's contents were lost, e.g. on a mode switch
+    LOG_WARN("GPUPixelTextureUploader: unmapping the unpack buffer failed");
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+#endif
+
+  UploadFromMemory(pixels, stride, format);
+}
+
+void GPUPixelTextureUploader::UploadFromMemory(const uint8_t* pixels,
+                                               int stride,
+                                               GLenum format) {
+  if (stride == width_ * channels_) {
+    GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, format,
+                            GL_UNSIGNED_BYTE, pixels));
+    return;
+  }
+#if defined(GPUPIXEL_GL_UNPACK_ROW_LENGTH)
+  if (has_unpack_row_length_ && stride % channels_ == 0) {
+    GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / channels_));
+    GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, format,
+                            GL_UNSIGNED_BYTE, pixels));
+    GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+    return;
+  }
+#endif
+  for (int y = 0; y < height_; ++y) {
+    GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width_, 1, format,
+                            GL_UNSIGNED_BYTE, pixels + y * stride));
+  }
+}
+
+void GPUPixelTextureUploader::MapNextBuffer() {
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  // The next buffer was submitted kRingSize - 1 frames ago, invalidating it
+  // lets the driver hand out fresh memory instead of waiting for that upload
+  current_ = (current_ + 1) % kRingSize;
+  GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[current_]));
+  mapped_ = (uint8_t*)glMapBufferRange(
+      GL_PIXEL_UNPACK_BUFFER, 0, width_ * height_ * channels_,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+#endif
+}
+
+void GPUPixelTextureUploader::ReleaseBuffers() {
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  if (!buffers_[0]) {
+    return;
+  }
+  if (mapped_) {
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers_[current_]));
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+  }
+  mapped_ = nullptr;
+  staged_ = false;
+  GL_CALL(glDeleteBuffers(kRingSize, buffers_));
+  std::memset(buffers_, 0, sizeof(buffers_));
+#endif
+}
+
+}  // namespace gpupixel
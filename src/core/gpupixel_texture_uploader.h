@@ -0,0 +1,81 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <mutex>
+#include "core/gpupixel_gl_include.h"
+
+namespace gpupixel {
+
+// Streams frames into a texture of one to four 8 bit channels.
+// Storage is only allocated when the size changes, frames are updated with
+// glTexSubImage2D from a ring of pixel unpack buffers.
+//
+// The next buffer of the ring stays mapped between frames, so Stage() can
+// copy the caller's pixels into it on the calling thread, while the GL thread
+// is busy with other work. Upload() then only unmaps and submits it. Without
+// a staged frame, or on platforms without buffer mapping, Upload() copies
+// from the given pointer itself.
+class GPUPixelTextureUploader {
+ public:
+  explicit GPUPixelTextureUploader(int channels);
+  // GL thread
+  ~GPUPixelTextureUploader();
+
+  // Any thread. Returns false when no mapped buffer of this size is ready,
+  // the pixels must then be passed to Upload(). |stride| is in bytes, 0 for
+  // tightly packed rows.
+  bool Stage(const uint8_t* pixels, int width, int height, int stride = 0);
+
+  // GL thread. Updates the texture bound to the active unit from the staged
+  // frame, or from |pixels| when nothing was staged. |format| overrides the
+  // channel layout of the pixels, e.g. GL_BGRA.
+  void Upload(const uint8_t* pixels,
+              int width,
+              int height,
+              int stride = 0,
+              GLenum format = 0);
+
+  GLuint GetTexture() const { return texture_; }
+  // Two channel textures are luminance-alpha where RG is unavailable, the
+  // second channel is then read from .a
+  bool IsSecondChannelInAlpha() const {
+    return format_ == GL_LUMINANCE_ALPHA;
+  }
+
+  static constexpr int kRingSize = 3;
+
+ private:
+  void Allocate(int width, int height);
+  void CopyRows(uint8_t* dst, const uint8_t* src, int stride) const;
+  void UploadFromMemory(const uint8_t* pixels, int stride, GLenum format);
+  void MapNextBuffer();
+  void ReleaseBuffers();
+
+  int channels_;
+  GLenum internal_format_;
+  GLenum format_;
+  // Of the context, an ES 2.0 one has none of them
+  bool has_pixel_buffers_ = false;
+  bool has_texture_storage_ = false;
+  bool has_unpack_row_length_ = false;
+  GLuint texture_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  std::mutex mutex_;
+  GLuint buffers_[kRingSize] = {0};
+  int current_ = 0;
+  // Mapped pointer of buffers_[current_], and whether Stage() filled it
+  uint8_t* mapped_ = nullptr;
+  bool staged_ = false;
+#endif
+};
+
+}  // namespace gpupixel
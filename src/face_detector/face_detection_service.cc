@@ -0,0 +1,196 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/face_detector/face_detection_service.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gpupixel {
+
+namespace {
+size_t FrameSize(int height, int stride, GPUPIXEL_FRAME_TYPE type) {
+  switch (type) {
+    case GPUPIXEL_FRAME_TYPE_YUVI420:
+    case GPUPIXEL_FRAME_TYPE_NV12:
+    case GPUPIXEL_FRAME_TYPE_NV21:
+      return (size_t)stride * height + (size_t)stride * ((height + 1) / 2);
+    default:
+      return (size_t)stride * height;
+  }
+}
+}  // namespace
+
+std::shared_ptr<FaceDetectionService> FaceDetectionService::GetInstance() {
+  return GetInstance(Options());
+}
+
+std::shared_ptr<FaceDetectionService> FaceDetectionService::GetInstance(
+    const Options& options) {
+  static std::mutex instance_mutex;
+  static std::shared_ptr<FaceDetectionService> instance;
+  std::unique_lock<std::mutex> lock(instance_mutex);
+  if (!instance) {
+    instance = Create(options);
+  }
+  return instance;
+}
+
+std::shared_ptr<FaceDetectionService> FaceDetectionService::Create(
+    const Options& options) {
+  return std::shared_ptr<FaceDetectionService>(
+      new FaceDetectionService(options));
+}
+
+FaceDetectionService::FaceDetectionService(const Options& options)
+    : options_(options) {
+  options_.num_workers = std::max(1, options_.num_workers);
+
+  // Detectors are created up front so model loading and warm-up never land
+  // on a stream's first frame.
+  for (int i = 0; i < options_.num_workers; i++) {
+    auto detector = FaceDetector::Create(options_.detector);
+    workers_.emplace_back(&FaceDetectionService::WorkerLoop, this, detector);
+  }
+}
+
+FaceDetectionService::~FaceDetectionService() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+int FaceDetectionService::RegisterStream(LandmarksCallback callback) {
+  auto stream = std::make_shared<Stream>();
+  stream->callback = callback;
+  std::unique_lock<std::mutex> lock(mutex_);
+  int stream_id = next_stream_id_++;
+  streams_[stream_id] = stream;
+  return stream_id;
+}
+
+void FaceDetectionService::UnregisterStream(int stream_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    return;
+  }
+  auto stream = it->second;
+  streams_.erase(it);
+  // Wait for an in-flight detection so the callback is never invoked after
+  // this returns. Must not be called from the stream's own callback.
+  cv_.wait(lock, [&] { return !stream->in_flight; });
+}
+
+bool FaceDetectionService::Submit(int stream_id,
+                                  const uint8_t* data,
+                                  int width,
+                                  int height,
+                                  int stride,
+                                  GPUPIXEL_FRAME_TYPE type,
+                                  int rotation) {
+  std::shared_ptr<Stream> stream;
+  Frame frame;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = streams_.find(stream_id);
+    if (it == streams_.end()) {
+      return false;
+    }
+    stream = it->second;
+    frame = std::move(stream->spare);
+  }
+
+  // Copy outside the lock so streams never serialize on each other's memcpy
+  size_t size = FrameSize(height, stride, type);
+  frame.data.resize(size);
+  std::memcpy(frame.data.data(), data, size);
+  frame.width = width;
+  frame.height = height;
+  frame.stride = stride;
+  frame.type = type;
+  frame.rotation = rotation;
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (streams_.find(stream_id) == streams_.end()) {
+      return false;
+    }
+    if (stream->has_pending) {
+      stats_.frames_dropped++;
+      stream->spare = std::move(stream->pending);
+    } else {
+      stream->submit_time = std::chrono::steady_clock::now();
+    }
+    stream->pending = std::move(frame);
+    stream->has_pending = true;
+  }
+  cv_.notify_all();
+  return true;
+}
+
+FaceDetectionService::Stats FaceDetectionService::GetStats() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+std::shared_ptr<FaceDetectionService::Stream>
+FaceDetectionService::NextReadyStream() const {
+  std::shared_ptr<Stream> next;
+  for (auto& it : streams_) {
+    auto& stream = it.second;
+    if (stream->has_pending && !stream->in_flight &&
+        (!next || stream->submit_time < next->submit_time)) {
+      next = stream;
+    }
+  }
+  return next;
+}
+
+void FaceDetectionService::WorkerLoop(std::shared_ptr<FaceDetector> detector) {
+  while (true) {
+    std::shared_ptr<Stream> stream;
+    Frame frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&] {
+        return !running_ || (stream = NextReadyStream()) != nullptr;
+      });
+      if (!running_) {
+        return;
+      }
+      stream->has_pending = false;
+      stream->in_flight = true;
+      frame = std::move(stream->pending);
+    }
+
+    auto landmarks = detector->Detect(
+        frame.data.data(), frame.width, frame.height, frame.stride,
+        GPUPIXEL_MODE_FMT_VIDEO, frame.type, frame.rotation);
+    if (stream->callback) {
+      stream->callback(landmarks);
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      stream->in_flight = false;
+      if (stream->spare.data.empty()) {
+        stream->spare = std::move(frame);
+      }
+      stats_.frames_detected++;
+    }
+    cv_.notify_all();
+  }
+}
+
+}  // namespace gpupixel
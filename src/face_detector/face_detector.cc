@@ -6,7 +6,11 @@
  */
 
 #include "gpupixel/face_detector/face_detector.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <utility>
+#include "libyuv.h"
 #include "mars_face_detector.h"
 #include "utils/filesystem.h"
 #include "utils/logging.h"
@@ -14,11 +18,36 @@
 
 namespace gpupixel {
 
+namespace {
+mars_face_kit::RotateType ToMarsRotateType(int rotation) {
+  switch (((rotation % 360) + 360) % 360) {
+    case 90:
+      return mars_face_kit::CLOCKWISE_ROTATE_90;
+    case 180:
+      return mars_face_kit::CLOCKWISE_ROTATE_180;
+    case 270:
+      return mars_face_kit::CLOCKWISE_ROTATE_270;
+    default:
+      return mars_face_kit::CLOCKWISE_ROTATE_0;
+  }
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - since)
+      .count();
+}
+}  // namespace
+
 std::shared_ptr<FaceDetector> FaceDetector::Create() {
-  return std::shared_ptr<FaceDetector>(new FaceDetector());
+  return Create(Options());
+}
+
+std::shared_ptr<FaceDetector> FaceDetector::Create(const Options& options) {
+  return std::shared_ptr<FaceDetector>(new FaceDetector(options));
 }
 
-FaceDetector::FaceDetector() {
+FaceDetector::FaceDetector(const Options& options) : options_(options) {
   mars_face_detector_ = mars_face_kit::MarsFaceDetector::CreateFaceDetector();
   auto path = Util::GetResourcePath() / "models";
 
@@ -27,7 +56,26 @@ FaceDetector::FaceDetector() {
   } else {
     LOG_ERROR("FaceDetector: models path not found: {}", path.string());
     assert(false && "FaceDetector: models path not found");
+    return;
+  }
+
+  WarmUp();
+}
+
+void FaceDetector::WarmUp() {
+  if (options_.warm_up_runs <= 0) {
+    return;
+  }
+  const int side = options_.max_input_side > 0
+                       ? std::min(options_.max_input_side, 640)
+                       : 640;
+  std::vector<uint8_t> blank(side * side, 0);
+  for (int i = 0; i < options_.warm_up_runs; i++) {
+    DetectImage(blank.data(), side, side, side,
+                mars_face_kit::PixelFormat::GRAY, GPUPIXEL_MODE_FMT_VIDEO, 0);
   }
+  LOG_DEBUG("FaceDetector: warm up {} runs, last {} ms",
+            options_.warm_up_runs, last_latency_.total_ms);
 }
 
 std::vector<float> FaceDetector::Detect(const uint8_t* data,
@@ -35,23 +83,176 @@ std::vector<float> FaceDetector::Detect(const uint8_t* data,
                                         int height,
                                         int stride,
                                         GPUPIXEL_MODE_FMT fmt,
-                                        GPUPIXEL_FRAME_TYPE type) {
+                                        GPUPIXEL_FRAME_TYPE type,
+                                        int rotation) {
+  switch (type) {
+    case GPUPIXEL_FRAME_TYPE_RGBA:
+      return DetectImage(data, width, height, stride,
+                         mars_face_kit::PixelFormat::RGBA, fmt, rotation);
+    case GPUPIXEL_FRAME_TYPE_BGRA:
+      return DetectImage(data, width, height, stride,
+                         mars_face_kit::PixelFormat::BGRA, fmt, rotation);
+    case GPUPIXEL_FRAME_TYPE_YUVI420: {
+      const uint8_t* data_u = data + stride * height;
+      const uint8_t* data_v = data_u + (stride / 2) * ((height + 1) / 2);
+      return DetectYUV(data, stride, data_u, stride / 2, data_v, stride / 2,
+                       width, height, fmt, type, rotation);
+    }
+    case GPUPIXEL_FRAME_TYPE_NV12:
+    case GPUPIXEL_FRAME_TYPE_NV21:
+      return DetectYUV(data, stride, data + stride * height, stride, nullptr,
+                       0, width, height, fmt, type, rotation);
+    default:
+      LOG_ERROR("FaceDetector: unsupported frame type {}", (int)type);
+      return std::vector<float>();
+  }
+}
+
+std::vector<float> FaceDetector::DetectYUV(const uint8_t* data_y,
+                                           int stride_y,
+                                           const uint8_t* data_u,
+                                           int stride_u,
+                                           const uint8_t* data_v,
+                                           int stride_v,
+                                           int width,
+                                           int height,
+                                           GPUPIXEL_MODE_FMT fmt,
+                                           GPUPIXEL_FRAME_TYPE type,
+                                           int rotation) {
+  // The detector takes a single base pointer and row pitch, so chroma can only
+  // be used when it sits right behind the luma plane with a matching pitch.
+  // Otherwise detect on the luma plane alone, which is all the face detection
+  // and alignment models really need.
+  bool contiguous = data_u == data_y + stride_y * height;
+  int pixel_format = mars_face_kit::PixelFormat::GRAY;
+  if (type == GPUPIXEL_FRAME_TYPE_NV12 || type == GPUPIXEL_FRAME_TYPE_NV21) {
+    if (contiguous && stride_u == stride_y) {
+      pixel_format = type == GPUPIXEL_FRAME_TYPE_NV12
+                         ? mars_face_kit::PixelFormat::YUV_NV12
+                         : mars_face_kit::PixelFormat::YUV_NV21;
+    }
+  } else if (type == GPUPIXEL_FRAME_TYPE_YUVI420) {
+    if (contiguous && stride_u == stride_y / 2 && stride_v == stride_u &&
+        data_v == data_u + stride_u * ((height + 1) / 2)) {
+      pixel_format = mars_face_kit::PixelFormat::YUV_I420;
+    }
+  } else {
+    LOG_ERROR("FaceDetector: frame type {} is not a YUV format", (int)type);
+    return std::vector<float>();
+  }
+
+  return DetectImage(data_y, width, height, stride_y, pixel_format, fmt,
+                     rotation);
+}
+
+std::vector<float> FaceDetector::DetectImage(const uint8_t* data,
+                                             int width,
+                                             int height,
+                                             int width_step,
+                                             int pixel_format,
+                                             GPUPIXEL_MODE_FMT fmt,
+                                             int rotation) {
+  auto start_time = std::chrono::steady_clock::now();
+
+  // Downscale video to the configured input size, the landmarks are
+  // normalized so the scale does not leak into the result.
+  int max_side = std::max(width, height);
+  if (fmt == GPUPIXEL_MODE_FMT_VIDEO && options_.max_input_side > 0 &&
+      max_side > options_.max_input_side) {
+    int scaled_width =
+        std::max(2, (width * options_.max_input_side / max_side) & ~1);
+    int scaled_height =
+        std::max(2, (height * options_.max_input_side / max_side) & ~1);
+    int scaled_size = scaled_width * scaled_height;
+    switch (pixel_format) {
+      case mars_face_kit::PixelFormat::RGBA:
+      case mars_face_kit::PixelFormat::BGRA:
+        scale_buffer_.resize(scaled_size * 4);
+        libyuv::ARGBScale(data, width_step, width, height,
+                          scale_buffer_.data(), scaled_width * 4, scaled_width,
+                          scaled_height, libyuv::kFilterBilinear);
+        width_step = scaled_width * 4;
+        break;
+      case mars_face_kit::PixelFormat::YUV_NV12:
+      case mars_face_kit::PixelFormat::YUV_NV21:
+        scale_buffer_.resize(scaled_size * 3 / 2);
+        libyuv::NV12Scale(data, width_step, data + width_step * height,
+                          width_step, width, height, scale_buffer_.data(),
+                          scaled_width, scale_buffer_.data() + scaled_size,
+                          scaled_width, scaled_width, scaled_height,
+                          libyuv::kFilterBilinear);
+        width_step = scaled_width;
+        break;
+      case mars_face_kit::PixelFormat::YUV_I420: {
+        const uint8_t* data_u = data + width_step * height;
+        const uint8_t* data_v = data_u + width_step / 2 * ((height + 1) / 2);
+        scale_buffer_.resize(scaled_size * 3 / 2);
+        libyuv::I420Scale(data, width_step, data_u, width_step / 2, data_v,
+                          width_step / 2, width, height, scale_buffer_.data(),
+                          scaled_width, scale_buffer_.data() + scaled_size,
+                          scaled_width / 2,
+                          scale_buffer_.data() + scaled_size * 5 / 4,
+                          scaled_width / 2, scaled_width, scaled_height,
+                          libyuv::kFilterBilinear);
+        width_step = scaled_width;
+        break;
+      }
+      default:
+        scale_buffer_.resize(scaled_size);
+        libyuv::ScalePlane(data, width_step, width, height,
+                           scale_buffer_.data(), scaled_width, scaled_width,
+                           scaled_height, libyuv::kFilterBilinear);
+        width_step = scaled_width;
+        break;
+    }
+    data = scale_buffer_.data();
+    width = scaled_width;
+    height = scaled_height;
+  }
+
   mars_face_kit::MarsImage image;
   image.data = (uint8_t*)data;
-  image.width = width == stride / 4 ? width : stride / 4;
+  image.width = width;
   image.height = height;
-  if (type == GPUPIXEL_FRAME_TYPE_RGBA) {
-    image.pixel_format = mars_face_kit::PixelFormat::RGBA;
-  } else if (type == GPUPIXEL_FRAME_TYPE_BGRA) {
-    image.pixel_format = mars_face_kit::PixelFormat::BGRA;
+  image.pixel_format = (mars_face_kit::PixelFormat)pixel_format;
+  image.width_step = width_step;
+  if (pixel_format == mars_face_kit::PixelFormat::RGBA ||
+      pixel_format == mars_face_kit::PixelFormat::BGRA) {
+    // The detector takes 4 byte pixels with width_step in pixels, padded
+    // rows are passed as a wider image
+    image.width = width_step / 4;
+    image.width_step = width;
+  }
+  // Stills are unrelated to each other, video frames carry their time
+  image.timestamp = fmt == GPUPIXEL_MODE_FMT_VIDEO
+                        ? std::chrono::duration<double, std::milli>(
+                              start_time.time_since_epoch())
+                              .count()
+                        : 0;
+  image.rotate_type = ToMarsRotateType(rotation);
+
+  // Landmarks are reported in the upright frame
+  if (image.rotate_type == mars_face_kit::CLOCKWISE_ROTATE_90 ||
+      image.rotate_type == mars_face_kit::CLOCKWISE_ROTATE_270) {
+    std::swap(width, height);
   }
-  image.width_step = width;
-  image.rotate_type = mars_face_kit::CLOCKWISE_ROTATE_0;
 
   std::vector<mars_face_kit::FaceDetectionInfo> face_info;
   std::vector<float> landmarks;
 
+  last_latency_.preprocess_ms = ElapsedMs(start_time);
+  auto inference_time = std::chrono::steady_clock::now();
   mars_face_detector_->Detect(image, face_info);
+  last_latency_.inference_ms = ElapsedMs(inference_time);
+
+  face_info.erase(
+      std::remove_if(face_info.begin(), face_info.end(),
+                     [this](const mars_face_kit::FaceDetectionInfo& info) {
+                       return info.score < options_.score_threshold;
+                     }),
+      face_info.end());
+  last_latency_.face_count = (int)face_info.size();
+
   if (face_info.size() > 0) {
     for (int i = 0; i < face_info[0].landmarks.size(); i++) {
       landmarks.push_back(face_info[0].landmarks[i].x / width);
@@ -110,6 +311,7 @@ std::vector<float> FaceDetector::Detect(const uint8_t* data,
     landmarks.push_back(point_y);
   }
 
+  last_latency_.total_ms = ElapsedMs(start_time);
   return landmarks;
 }
 
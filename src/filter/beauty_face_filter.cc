@@ -9,6 +9,13 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
+namespace {
+// The box blur reads every 4th texel, the pyramid needs the full extent
+int PyramidRadius(float radius) {
+  return (int)(radius * 4);
+}
+}  // namespace
+
 BeautyFaceFilter::BeautyFaceFilter() {}
 
 BeautyFaceFilter::~BeautyFaceFilter() {}
@@ -47,23 +54,26 @@ bool BeautyFaceFilter::Init() {
 
   RegisterProperty("whiteness", 0,
                    "The whiteness of filter with range between -1 and 1.",
-                   [this](float& val) { SetWhite(val); });
+                   [this](float& val) { beauty_face_filter_->SetWhite(val); });
 
   RegisterProperty("skin_smoothing", 0,
                    "The smoothing of filter with range between -1 and 1.",
-                   [this](float& val) { SetBlurAlpha(val); });
+                   [this](float& val) {
+                     beauty_face_filter_->SetBlurAlpha(val);
+                   });
+
+  RegisterProperty("blur_engine", GaussianBlurFilter::SEPARABLE,
+                   "0 for the box blur, 1 for the pyramid blur.",
+                   [this](int& engine) {
+                     SetBlurEngine(engine == GaussianBlurFilter::PYRAMID
+                                       ? GaussianBlurFilter::PYRAMID
+                                       : GaussianBlurFilter::SEPARABLE);
+                   });
+  whiteness_property_ = GetPropertyHandle("whiteness");
+  skin_smoothing_property_ = GetPropertyHandle("skin_smoothing");
   return true;
 }
 
-void BeautyFaceFilter::SetInputFramebuffer(
-    std::shared_ptr<GPUPixelFramebuffer> framebuffer,
-    RotationMode rotation_mode /* = NoRotation*/,
-    int texIdx /* = 0*/) {
-  for (auto& filter : filters_) {
-    filter->SetInputFramebuffer(framebuffer, rotation_mode, texIdx);
-  }
-}
-
 void BeautyFaceFilter::SetHighPassDelta(float highPassDelta) {
   box_high_pass_filter_->SetDelta(highPassDelta);
 }
@@ -73,15 +83,46 @@ void BeautyFaceFilter::SetSharpen(float sharpen) {
 }
 
 void BeautyFaceFilter::SetBlurAlpha(float blurAlpha) {
-  beauty_face_filter_->SetBlurAlpha(blurAlpha);
+  SetProperty(skin_smoothing_property_, blurAlpha);
 }
 
 void BeautyFaceFilter::SetWhite(float white) {
-  beauty_face_filter_->SetWhite(white);
+  SetProperty(whiteness_property_, white);
 }
 
 void BeautyFaceFilter::SetRadius(float radius) {
+  radius_ = radius;
   box_blur_filter_->SetRadius(radius);
   box_high_pass_filter_->SetRadius(radius);
+  if (pyramid_blur_filter_) {
+    pyramid_blur_filter_->SetRadius(PyramidRadius(radius));
+  }
+}
+
+void BeautyFaceFilter::SetBlurEngine(GaussianBlurFilter::BlurEngine engine) {
+  if (engine == engine_) {
+    return;
+  }
+  engine_ = engine;
+
+  GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (engine_ == GaussianBlurFilter::PYRAMID && !pyramid_blur_filter_) {
+      pyramid_blur_filter_ =
+          DualKawaseBlurFilter::Create(PyramidRadius(radius_));
+    }
+
+    std::shared_ptr<Filter> from = box_blur_filter_;
+    std::shared_ptr<Filter> to = pyramid_blur_filter_;
+    if (engine_ == GaussianBlurFilter::SEPARABLE) {
+      std::swap(from, to);
+    }
+    GraphEdit edit;
+    from->RemoveSink(beauty_face_filter_);
+    RemoveFilter(from);
+    auto filters = GetFilters();
+    filters.insert(filters.begin(), to);
+    SetFilters(filters);
+    to->AddSink(beauty_face_filter_, 1);
+  });
 }
 }  // namespace gpupixel
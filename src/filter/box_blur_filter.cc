@@ -59,4 +59,9 @@ void BoxBlurFilter::SetTexelSpacingMultiplier(float value) {
   vertical_blur_filter_->SetTexelSpacingMultiplier(value);
 }
 
+std::string BoxBlurFilter::GetFingerprint() const {
+  return "BoxBlurFilter{" + horizontal_blur_filter_->GetFingerprint() + "," +
+         vertical_blur_filter_->GetFingerprint() + "}";
+}
+
 }  // namespace gpupixel
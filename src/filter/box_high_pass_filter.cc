@@ -41,15 +41,6 @@ bool BoxHighPassFilter::Init() {
   return true;
 }
 
-void BoxHighPassFilter::SetInputFramebuffer(
-    std::shared_ptr<GPUPixelFramebuffer> framebuffer,
-    RotationMode rotation_mode /* = NoRotation*/,
-    int texIdx /* = 0*/) {
-  for (auto& filter : filters_) {
-    filter->SetInputFramebuffer(framebuffer, rotation_mode, texIdx);
-  }
-}
-
 void BoxHighPassFilter::SetRadius(float radius) {
   box_blur_filter_->SetRadius(radius);
 }
@@ -11,10 +11,61 @@
 #include "utils/util.h"
 namespace gpupixel {
 
+const std::string kBoxDoublingVertexShaderString = R"(
+    attribute vec4 position; attribute vec4 inputTextureCoordinate;
+    attribute vec4 inputTextureCoordinate2;
+
+    varying vec2 textureCoordinate;
+    varying vec2 textureCoordinate2;
+
+    void main() {
+      gl_Position = position;
+      textureCoordinate = inputTextureCoordinate.xy;
+      textureCoordinate2 = inputTextureCoordinate2.xy;
+    })";
+
+// Blends a box with a shifted one: doubling a box width when both inputs
+// are the same texture, or appending a power of two width to the
+// accumulated box
+#if defined(GPUPIXEL_GLES_SHADER)
+const std::string kBoxDoublingFragmentShaderString = R"(
+    varying highp vec2 textureCoordinate; varying highp vec2 textureCoordinate2;
+    uniform sampler2D inputImageTexture;
+    uniform sampler2D inputImageTexture2;
+    uniform highp vec2 offset;
+    uniform highp float weight;
+
+    void main() {
+      gl_FragColor =
+          mix(texture2D(inputImageTexture, textureCoordinate),
+              texture2D(inputImageTexture2, textureCoordinate2 + offset),
+              weight);
+    })";
+#else
+const std::string kBoxDoublingFragmentShaderString = R"(
+    varying vec2 textureCoordinate; varying vec2 textureCoordinate2;
+    uniform sampler2D inputImageTexture;
+    uniform sampler2D inputImageTexture2;
+    uniform vec2 offset;
+    uniform float weight;
+
+    void main() {
+      gl_FragColor =
+          mix(texture2D(inputImageTexture, textureCoordinate),
+              texture2D(inputImageTexture2, textureCoordinate2 + offset),
+              weight);
+    })";
+#endif
+
 BoxMonoBlurFilter::BoxMonoBlurFilter(Type type)
     : GaussianBlurMonoFilter(type) {}
 
-BoxMonoBlurFilter::~BoxMonoBlurFilter() {}
+BoxMonoBlurFilter::~BoxMonoBlurFilter() {
+  if (doubling_program_) {
+    delete doubling_program_;
+    doubling_program_ = nullptr;
+  }
+}
 
 std::shared_ptr<BoxMonoBlurFilter> BoxMonoBlurFilter::Create(Type type,
                                                              int radius,
@@ -43,6 +94,9 @@ void BoxMonoBlurFilter::SetRadius(int radius) {
 
   if (newBlurRadius != radius_) {
     radius_ = newBlurRadius;
+    if (radius_ > kMaxSinglePassRadius) {
+      return;
+    }
 
     if (filter_program_) {
       delete filter_program_;
@@ -53,9 +107,163 @@ void BoxMonoBlurFilter::SetRadius(int radius) {
   }
 }
 
+void BoxMonoBlurFilter::UpdateBlurProgram() {
+  if (radius_ > kMaxSinglePassRadius && filter_program_) {
+    return;
+  }
+  if (filter_program_) {
+    delete filter_program_;
+    filter_program_ = 0;
+  }
+  InitWithShaderString(GenerateOptimizedVertexShaderString(radius_, sigma_),
+                       GenerateOptimizedFragmentShaderString(radius_, sigma_));
+}
+
+bool BoxMonoBlurFilter::DoRender(bool updateSinks) {
+  if (radius_ <= kMaxSinglePassRadius) {
+    return GaussianBlurMonoFilter::DoRender(updateSinks);
+  }
+  return RenderRecursiveDoubling(updateSinks);
+}
+
+Vector2 BoxMonoBlurFilter::GetAxisStep(RotationMode rotation) const {
+  // Texture space step of one output pixel along the blur axis, taken from
+  // the quad's texture coordinates so every rotation and flip is covered
+  const float* coordinates = GetTextureCoordinate(rotation);
+  if (type_ == HORIZONTAL) {
+    float scale = horizontal_texel_spacing_ / framebuffer_->GetWidth();
+    return Vector2((coordinates[2] - coordinates[0]) * scale,
+                   (coordinates[3] - coordinates[1]) * scale);
+  }
+  float scale = vertical_texel_spacing_ / framebuffer_->GetHeight();
+  return Vector2((coordinates[4] - coordinates[0]) * scale,
+                 (coordinates[5] - coordinates[1]) * scale);
+}
+
+bool BoxMonoBlurFilter::RenderRecursiveDoubling(bool updateSinks) {
+  if (!doubling_program_) {
+    doubling_program_ = GPUPixelGLProgram::CreateWithShaderString(
+        kBoxDoublingVertexShaderString, kBoxDoublingFragmentShaderString);
+    if (!doubling_program_) {
+      return false;
+    }
+    doubling_position_attribute_ =
+        doubling_program_->GetAttribLocation("position");
+  }
+
+  // Every pass rounds its result, half floats keep that from adding up over
+  // the passes where the context can render to them
+  int width = framebuffer_->GetWidth();
+  int height = framebuffer_->GetHeight();
+  TextureAttributes attributes =
+      GPUPixelFramebuffer::GetFormatTextureAttributes(
+          GPUPIXEL_FRAMEBUFFER_FORMAT_RGBA16F);
+  for (auto& framebuffer : doubling_framebuffers_) {
+    if (!framebuffer || framebuffer->GetWidth() != width ||
+        framebuffer->GetHeight() != height) {
+      framebuffer = GPUPixelContext::GetInstance()
+                        ->GetFramebufferFactory()
+                        ->CreateFramebuffer(width, height, false, attributes);
+    }
+  }
+
+  // The box [x - r, x + r] is assembled left to right from the binary digits
+  // of its width: |doubled| holds the box [x, x + doubled_width) and each set
+  // bit appends it behind the |accumulated_width| texels gathered so far.
+  // Both passes are two taps, the offsets carry the window positions.
+  const InputFrameBufferInfo& input = input_framebuffers_.begin()->second;
+  std::shared_ptr<GPUPixelFramebuffer> doubled = input.frame_buffer;
+  RotationMode doubled_rotation = input.rotation_mode;
+  std::shared_ptr<GPUPixelFramebuffer> accumulated;
+
+  const int box_width = radius_ * 2 + 1;
+  int doubled_width = 1;
+  int accumulated_width = 0;
+  int next_doubled = 0;
+  int next_accumulated = 2;
+  while (true) {
+    if (box_width & doubled_width) {
+      float weight =
+          doubled_width / (float)(accumulated_width + doubled_width);
+      std::shared_ptr<GPUPixelFramebuffer> target =
+          accumulated_width + doubled_width == box_width
+              ? framebuffer_
+              : doubling_framebuffers_[next_accumulated];
+      // The first block has nothing to blend with, weight 1 ignores it
+      RenderDoublingPass(target, accumulated ? accumulated : doubled,
+                         accumulated ? NoRotation : doubled_rotation, doubled,
+                         doubled_rotation,
+                         GetAxisStep(doubled_rotation) *
+                             (float)(accumulated_width - radius_),
+                         weight);
+      accumulated_width += doubled_width;
+      if (accumulated_width == box_width) {
+        break;
+      }
+      accumulated = target;
+      next_accumulated = next_accumulated == 2 ? 3 : 2;
+    }
+
+    std::shared_ptr<GPUPixelFramebuffer> target =
+        doubling_framebuffers_[next_doubled];
+    RenderDoublingPass(target, doubled, doubled_rotation, doubled,
+                       doubled_rotation,
+                       GetAxisStep(doubled_rotation) * (float)doubled_width,
+                       0.5);
+    doubled = target;
+    doubled_rotation = NoRotation;
+    doubled_width *= 2;
+    next_doubled = 1 - next_doubled;
+  }
+
+  return Source::DoRender(updateSinks);
+}
+
+void BoxMonoBlurFilter::RenderDoublingPass(
+    std::shared_ptr<GPUPixelFramebuffer> target,
+    std::shared_ptr<GPUPixelFramebuffer> first,
+    RotationMode first_rotation,
+    std::shared_ptr<GPUPixelFramebuffer> second,
+    RotationMode second_rotation,
+    Vector2 second_offset,
+    float weight) {
+  static const float image_vertices[] = {
+      -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
+  };
+
+  GPUPixelContext::GetInstance()->SetActiveGlProgram(doubling_program_);
+  target->Activate();
+
+  GL_CALL(glActiveTexture(GL_TEXTURE0));
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, first->GetTexture()));
+  doubling_program_->SetUniformValue("inputImageTexture", 0);
+  GL_CALL(glActiveTexture(GL_TEXTURE1));
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, second->GetTexture()));
+  doubling_program_->SetUniformValue("inputImageTexture2", 1);
+  doubling_program_->SetUniformValue("offset", second_offset);
+  doubling_program_->SetUniformValue("weight", weight);
+
+  uint32_t first_coordinate_attribute =
+      doubling_program_->GetAttribLocation("inputTextureCoordinate");
+  GL_CALL(glEnableVertexAttribArray(first_coordinate_attribute));
+  GL_CALL(glVertexAttribPointer(first_coordinate_attribute, 2, GL_FLOAT, 0, 0,
+                                GetTextureCoordinate(first_rotation)));
+  uint32_t second_coordinate_attribute =
+      doubling_program_->GetAttribLocation("inputTextureCoordinate2");
+  GL_CALL(glEnableVertexAttribArray(second_coordinate_attribute));
+  GL_CALL(glVertexAttribPointer(second_coordinate_attribute, 2, GL_FLOAT, 0,
+                                0, GetTextureCoordinate(second_rotation)));
+  GL_CALL(glEnableVertexAttribArray(doubling_position_attribute_));
+  GL_CALL(glVertexAttribPointer(doubling_position_attribute_, 2, GL_FLOAT, 0,
+                                0, image_vertices));
+  GL_CALL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+
+  target->Deactivate();
+}
+
 std::string BoxMonoBlurFilter::GenerateOptimizedVertexShaderString(
     int radius,
-    float sigma) {
+    float /*sigma*/) {
   if (radius < 1) {
     return kDefaultVertexShader;
   }
@@ -84,7 +292,7 @@ std::string BoxMonoBlurFilter::GenerateOptimizedVertexShaderString(
 
   // Inner offset loop
   shaderStr += "blurCoordinates[0] = inputTextureCoordinate.xy;\n";
-  for (uint32_t currentOptimizedOffset = 0;
+  for (int currentOptimizedOffset = 0;
        currentOptimizedOffset < numberOfOptimizedOffsets;
        currentOptimizedOffset++) {
     float optimizedOffset = (float)(currentOptimizedOffset * 2) + 1.5;
@@ -105,7 +313,7 @@ std::string BoxMonoBlurFilter::GenerateOptimizedVertexShaderString(
 
 std::string BoxMonoBlurFilter::GenerateOptimizedFragmentShaderString(
     int radius,
-    float sigma) {
+    float /*sigma*/) {
   if (radius < 1) {
     return kDefaultFragmentShader;
   }
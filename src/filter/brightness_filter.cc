@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/brightness_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 #if defined(GPUPIXEL_GLES_SHADER) || defined(GPUPIXEL_MAC)
@@ -67,4 +68,8 @@ bool BrightnessFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string BrightnessFilter::GetFingerprint() const {
+  return Util::StringFormat("BrightnessFilter:%f", brightness_factor_);
+}
+
 }  // namespace gpupixel
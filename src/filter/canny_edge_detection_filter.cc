@@ -6,9 +6,98 @@
  */
 
 #include "gpupixel/filter/canny_edge_detection_filter.h"
+#include <cmath>
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
+namespace {
+// Match the defaults of the multi-pass chain
+const int kBlurRadius = 4;
+const float kBlurSigma = 2.0;
+
+const std::string kCannyLuminanceStage = R"(
+    vec4 color = sampleInput(ivec2(0));
+    return vec4(vec3(dot(color.rgb, vec3(0.2125, 0.7154, 0.0721))), color.a);
+)";
+
+const std::string kCannySobelStage = R"(
+    float bottomLeftIntensity = sampleInput(ivec2(-1, 1)).r;
+    float topRightIntensity = sampleInput(ivec2(1, -1)).r;
+    float topLeftIntensity = sampleInput(ivec2(-1, -1)).r;
+    float bottomRightIntensity = sampleInput(ivec2(1, 1)).r;
+    float leftIntensity = sampleInput(ivec2(-1, 0)).r;
+    float rightIntensity = sampleInput(ivec2(1, 0)).r;
+    float bottomIntensity = sampleInput(ivec2(0, 1)).r;
+    float topIntensity = sampleInput(ivec2(0, -1)).r;
+
+    vec2 gradientDirection;
+    gradientDirection.x = -bottomLeftIntensity - 2.0 * leftIntensity -
+                          topLeftIntensity + bottomRightIntensity +
+                          2.0 * rightIntensity + topRightIntensity;
+    gradientDirection.y = -topLeftIntensity - 2.0 * topIntensity -
+                          topRightIntensity + bottomLeftIntensity +
+                          2.0 * bottomIntensity + bottomRightIntensity;
+
+    float gradientMagnitude = length(gradientDirection);
+    vec2 normalizedDirection = normalize(gradientDirection);
+    normalizedDirection = sign(normalizedDirection) *
+                          floor(abs(normalizedDirection) + 0.617316);
+    normalizedDirection = (normalizedDirection + 1.0) * 0.5;
+    return vec4(gradientMagnitude, normalizedDirection.x,
+                normalizedDirection.y, 1.0);
+)";
+
+const std::string kCannyNonMaximumSuppressionStage = R"(
+    vec3 currentGradientAndDirection = sampleInput(ivec2(0)).rgb;
+    ivec2 gradientDirection =
+        ivec2(round(currentGradientAndDirection.gb * 2.0 - 1.0));
+
+    float firstSampledGradientMagnitude = sampleInput(gradientDirection).r;
+    float secondSampledGradientMagnitude = sampleInput(-gradientDirection).r;
+
+    float multiplier =
+        step(firstSampledGradientMagnitude, currentGradientAndDirection.r);
+    multiplier = multiplier * step(secondSampledGradientMagnitude,
+                                   currentGradientAndDirection.r);
+    multiplier = multiplier *
+                 smoothstep(0.1, 0.5, currentGradientAndDirection.r);
+    return vec4(multiplier, multiplier, multiplier, 1.0);
+)";
+
+const std::string kCannyWeakPixelInclusionStage = R"(
+    float pixelIntensitySum = 0.0;
+    for (int y = -1; y <= 1; y++) {
+      for (int x = -1; x <= 1; x++) {
+        pixelIntensitySum += sampleInput(ivec2(x, y)).r;
+      }
+    }
+    float centerIntensity = sampleInput(ivec2(0)).r;
+    float sumTest = step(1.5, pixelIntensitySum);
+    float pixelTest = step(0.01, centerIntensity);
+    return vec4(vec3(sumTest * pixelTest), 1.0);
+)";
+
+// One axis of the Gaussian, the weights are baked in as constants
+std::string GenerateBlurStage(bool horizontal) {
+  std::vector<float> weights(kBlurRadius + 1);
+  float sum_of_weights = 0.0;
+  for (int i = 0; i <= kBlurRadius; i++) {
+    weights[i] = exp(-(i * i) / (2.0 * kBlurSigma * kBlurSigma));
+    sum_of_weights += i == 0 ? weights[i] : 2.0 * weights[i];
+  }
+
+  std::string source = "float sum = 0.0;\n";
+  for (int i = -kBlurRadius; i <= kBlurRadius; i++) {
+    source += Util::StringFormat(
+        "sum += sampleInput(ivec2(%d, %d)).r * %f;\n", horizontal ? i : 0,
+        horizontal ? 0 : i, weights[std::abs(i)] / sum_of_weights);
+  }
+  source += "return vec4(sum, sum, sum, 1.0);\n";
+  return source;
+}
+}  // namespace
+
 CannyEdgeDetectionFilter::CannyEdgeDetectionFilter()
     : grayscale_filter_(0),
       blur_filter_(0),
@@ -34,11 +123,26 @@ bool CannyEdgeDetectionFilter::Init() {
     return false;
   }
 
+  fused_filter_ = StencilChainFilter::Create({
+      {kCannyLuminanceStage, 0, 0},
+      {GenerateBlurStage(true), kBlurRadius, 0},
+      {GenerateBlurStage(false), 0, kBlurRadius},
+      {kCannySobelStage, 1, 1},
+      {kCannyNonMaximumSuppressionStage, 1, 1},
+      {kCannyWeakPixelInclusionStage, 1, 1},
+  });
+  if (fused_filter_) {
+    AddFilter(fused_filter_);
+    return true;
+  }
+
   // 1. convert image to luminance
   grayscale_filter_ = GrayscaleFilter::Create();
+  grayscale_filter_->SetOutputFormat(GPUPIXEL_FRAMEBUFFER_FORMAT_R8);
 
   // 2. apply a varialbe Gaussian blur
-  blur_filter_ = SingleComponentGaussianBlurFilter::Create();
+  blur_filter_ =
+      SingleComponentGaussianBlurFilter::Create(kBlurRadius, kBlurSigma);
 
   // 3. soble edge detection
   edge_detection_filter_ = DirectionalSobelEdgeDetectionFilter::Create();
@@ -39,4 +39,8 @@ bool ColorInvertFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string ColorInvertFilter::GetFingerprint() const {
+  return "ColorInvertFilter";
+}
+
 }  // namespace gpupixel
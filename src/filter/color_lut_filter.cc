@@ -0,0 +1,222 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/filter/color_lut_filter.h"
+#include <map>
+#include <typeinfo>
+#include "core/gpupixel_context.h"
+#include "utils/util.h"
+
+namespace gpupixel {
+
+#if defined(GPUPIXEL_GLES_SHADER)
+const std::string kColorLutIdentityFragmentShaderString = R"(
+    precision highp float;
+    varying highp vec2 textureCoordinate;
+
+    void main() {
+      vec2 pixel = floor(textureCoordinate * 512.0);
+      vec2 tile = floor(pixel / 64.0);
+      vec2 cell = pixel - tile * 64.0;
+      gl_FragColor = vec4(cell / 63.0, (tile.y * 8.0 + tile.x) / 63.0, 1.0);
+    })";
+
+const std::string kColorLutFragmentShaderString = R"(
+    precision highp float;
+    varying highp vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform sampler2D lookupTexture;
+
+    void main() {
+      vec4 color = clamp(texture2D(inputImageTexture, textureCoordinate), 0.0,
+                         1.0);
+      float blueColor = color.b * 63.0;
+      vec2 quad1;
+      quad1.y = floor(floor(blueColor) / 8.0);
+      quad1.x = floor(blueColor) - (quad1.y * 8.0);
+      vec2 quad2;
+      quad2.y = floor(ceil(blueColor) / 8.0);
+      quad2.x = ceil(blueColor) - (quad2.y * 8.0);
+      vec2 texPos = color.rg * (63.0 / 512.0) + 0.5 / 512.0;
+      vec3 newColor1 = texture2D(lookupTexture, quad1 * 0.125 + texPos).rgb;
+      vec3 newColor2 = texture2D(lookupTexture, quad2 * 0.125 + texPos).rgb;
+      gl_FragColor = vec4(mix(newColor1, newColor2, fract(blueColor)), color.a);
+    })";
+#elif defined(GPUPIXEL_GL_SHADER)
+const std::string kColorLutIdentityFragmentShaderString = R"(
+    varying vec2 textureCoordinate;
+
+    void main() {
+      vec2 pixel = floor(textureCoordinate * 512.0);
+      vec2 tile = floor(pixel / 64.0);
+      vec2 cell = pixel - tile * 64.0;
+      gl_FragColor = vec4(cell / 63.0, (tile.y * 8.0 + tile.x) / 63.0, 1.0);
+    })";
+
+const std::string kColorLutFragmentShaderString = R"(
+    varying vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform sampler2D lookupTexture;
+
+    void main() {
+      vec4 color = clamp(texture2D(inputImageTexture, textureCoordinate), 0.0,
+                         1.0);
+      float blueColor = color.b * 63.0;
+      vec2 quad1;
+      quad1.y = floor(floor(blueColor) / 8.0);
+      quad1.x = floor(blueColor) - (quad1.y * 8.0);
+      vec2 quad2;
+      quad2.y = floor(ceil(blueColor) / 8.0);
+      quad2.x = ceil(blueColor) - (quad2.y * 8.0);
+      vec2 texPos = color.rg * (63.0 / 512.0) + 0.5 / 512.0;
+      vec3 newColor1 = texture2D(lookupTexture, quad1 * 0.125 + texPos).rgb;
+      vec3 newColor2 = texture2D(lookupTexture, quad2 * 0.125 + texPos).rgb;
+      gl_FragColor = vec4(mix(newColor1, newColor2, fract(blueColor)), color.a);
+    })";
+#endif
+
+namespace {
+// Baked lattices by chain fingerprint, shared by all filters with the same
+// grade. Only touched on the GL thread.
+std::map<std::string, std::weak_ptr<GPUPixelFramebuffer>>& GetLutCache() {
+  static std::map<std::string, std::weak_ptr<GPUPixelFramebuffer>> cache;
+  return cache;
+}
+}  // namespace
+
+ColorLutFilter::ColorLutFilter() {}
+
+ColorLutFilter::~ColorLutFilter() {
+  delete identity_program_;
+}
+
+std::shared_ptr<ColorLutFilter> ColorLutFilter::Create(
+    const std::vector<std::shared_ptr<Filter>>& chain) {
+  auto ret = std::shared_ptr<ColorLutFilter>(new ColorLutFilter());
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (ret && !ret->Init(chain)) {
+      ret.reset();
+    }
+  });
+  return ret;
+}
+
+bool ColorLutFilter::Init(const std::vector<std::shared_ptr<Filter>>& chain) {
+  for (auto& filter : chain) {
+    if (!filter || filter->GetFingerprint().empty()) {
+      LOG_ERROR("ColorLutFilter: {} is not a pure colour filter",
+                filter ? typeid(*filter).name() : "null");
+      return false;
+    }
+  }
+  chain_ = chain;
+
+  if (!InitWithFragmentShaderString(kColorLutFragmentShaderString)) {
+    return false;
+  }
+  identity_program_ = GPUPixelGLProgram::CreateWithShaderString(
+      kDefaultVertexShader, kColorLutIdentityFragmentShaderString);
+  return identity_program_ != nullptr;
+}
+
+std::string ColorLutFilter::GetChainFingerprint() const {
+  std::string fingerprint;
+  for (auto& filter : chain_) {
+    fingerprint += filter->GetFingerprint() + ";";
+  }
+  return fingerprint;
+}
+
+std::string ColorLutFilter::GetFingerprint() const {
+  return "ColorLutFilter{" + GetChainFingerprint() + "}";
+}
+
+void ColorLutFilter::UpdateLut() {
+  // The chain never renders outside BakeLut(), its values are applied here
+  for (auto& filter : chain_) {
+    filter->ApplyPendingProperties();
+  }
+  std::string key = GetChainFingerprint();
+  if (lut_framebuffer_ && key == lut_key_) {
+    return;
+  }
+
+  auto& cache = GetLutCache();
+  auto it = cache.find(key);
+  lut_framebuffer_ = it != cache.end() ? it->second.lock() : nullptr;
+  if (!lut_framebuffer_) {
+    lut_framebuffer_ = BakeLut();
+    // Drop lattices nobody holds any more before adding this one
+    for (auto entry = cache.begin(); entry != cache.end();) {
+      entry = entry->second.expired() ? cache.erase(entry) : std::next(entry);
+    }
+    cache[key] = lut_framebuffer_;
+  }
+  lut_key_ = key;
+}
+
+std::shared_ptr<GPUPixelFramebuffer> ColorLutFilter::BakeLut() {
+  auto factory = GPUPixelContext::GetInstance()->GetFramebufferFactory();
+  if (!identity_framebuffer_) {
+    identity_framebuffer_ =
+        factory->CreateFramebuffer(kLutImageSize, kLutImageSize);
+
+    // The identity lattice, each texel holds its own colour
+    static const float image_vertices[] = {
+        -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
+    };
+    static const float texture_vertices[] = {
+        0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+    };
+    GPUPixelContext::GetInstance()->SetActiveGlProgram(identity_program_);
+    identity_framebuffer_->Activate();
+    uint32_t position_attribute =
+        identity_program_->GetAttribLocation("position");
+    uint32_t tex_coord_attribute =
+        identity_program_->GetAttribLocation("inputTextureCoordinate");
+    GL_CALL(glEnableVertexAttribArray(position_attribute));
+    GL_CALL(glVertexAttribPointer(position_attribute, 2, GL_FLOAT, 0, 0,
+                                  image_vertices));
+    GL_CALL(glEnableVertexAttribArray(tex_coord_attribute));
+    GL_CALL(glVertexAttribPointer(tex_coord_attribute, 2, GL_FLOAT, 0, 0,
+                                  texture_vertices));
+    GL_CALL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+    identity_framebuffer_->Deactivate();
+  }
+
+  // Run the lattice through the chain, each filter renders into its own
+  // framebuffer
+  std::shared_ptr<GPUPixelFramebuffer> result = identity_framebuffer_;
+  for (auto& filter : chain_) {
+    filter->SetInputFramebuffer(result, NoRotation, 0);
+    filter->Render();
+    result = filter->GetFramebuffer();
+    filter->ResetAndClean();
+  }
+
+  // The last filter renders into the same framebuffer on the next bake, so
+  // cached lattices get a copy of their own
+  auto lut = factory->CreateFramebuffer(kLutImageSize, kLutImageSize);
+  result->Activate();
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, lut->GetTexture()));
+  GL_CALL(glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, kLutImageSize,
+                              kLutImageSize));
+  result->Deactivate();
+  return lut;
+}
+
+bool ColorLutFilter::DoRender(bool updateSinks) {
+  UpdateLut();
+
+  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
+  GL_CALL(glActiveTexture(GL_TEXTURE2));
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, lut_framebuffer_->GetTexture()));
+  filter_program_->SetUniformValue("lookupTexture", 2);
+  return Filter::DoRender(updateSinks);
+}
+
+}  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/color_matrix_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 #if defined(GPUPIXEL_GLES_SHADER)
@@ -80,4 +81,13 @@ bool ColorMatrixFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string ColorMatrixFilter::GetFingerprint() const {
+  std::string fingerprint =
+      Util::StringFormat("ColorMatrixFilter:%f", intensity_factor_);
+  for (float value : color_matrix_.m) {
+    fingerprint += Util::StringFormat(":%f", value);
+  }
+  return fingerprint;
+}
+
 }  // namespace gpupixel
@@ -0,0 +1,132 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/filter/compute_filter.h"
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_gl_compute.h"
+#include "utils/util.h"
+
+namespace gpupixel {
+
+ComputeFilter::ComputeFilter() {}
+
+ComputeFilter::~ComputeFilter() {}
+
+std::shared_ptr<ComputeFilter> ComputeFilter::Create(
+    const std::string& compute_shader_source,
+    const std::string& fragment_shader_source,
+    int input_number /* = 1*/) {
+  auto ret = std::shared_ptr<ComputeFilter>(new ComputeFilter());
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (ret && !ret->InitWithComputeShaderString(compute_shader_source,
+                                                 fragment_shader_source,
+                                                 input_number)) {
+      ret.reset();
+    }
+  });
+  return ret;
+}
+
+bool ComputeFilter::InitWithComputeShaderString(
+    const std::string& compute_shader_source,
+    const std::string& fragment_shader_source,
+    int input_number /* = 1*/) {
+  if (GPUPixelContext::GetInstance()->IsComputeSupported()) {
+    input_count_ = input_number;
+    filter_program_ = GPUPixelGLProgram::CreateWithComputeShaderString(
+        GetComputeShaderHeader(input_number) + compute_shader_source);
+    if (filter_program_) {
+      using_compute_ = true;
+      return true;
+    }
+    LOG_WARN("ComputeFilter: compute shader failed to build");
+  }
+  using_compute_ = false;
+  if (fragment_shader_source.empty()) {
+    return false;
+  }
+  return InitWithFragmentShaderString(fragment_shader_source, input_number);
+}
+
+std::string ComputeFilter::GetComputeShaderHeader(int input_number) const {
+  std::string header = Util::StringFormat(
+      "#version 430\n"
+      "#define WORK_GROUP_SIZE %d\n"
+      "layout(local_size_x = WORK_GROUP_SIZE, "
+      "local_size_y = WORK_GROUP_SIZE) in;\n"
+      "layout(binding = 0) writeonly uniform image2D outputImage;\n"
+      "uniform sampler2D inputImageTexture;\n",
+      kWorkGroupSize);
+  for (int i = 1; i < input_number; ++i) {
+    header += Util::StringFormat("uniform sampler2D inputImageTexture%d;\n", i);
+  }
+  header +=
+      "uniform vec2 textureCoordinateOrigin;\n"
+      "uniform vec2 textureCoordinateStepX;\n"
+      "uniform vec2 textureCoordinateStepY;\n"
+      "vec2 textureCoordinateAt(ivec2 pixel) {\n"
+      "  return textureCoordinateOrigin +\n"
+      "         (float(pixel.x) + 0.5) * textureCoordinateStepX +\n"
+      "         (float(pixel.y) + 0.5) * textureCoordinateStepY;\n"
+      "}\n";
+  return header;
+}
+
+bool ComputeFilter::DoRender(bool update_sinks) {
+  if (!using_compute_) {
+    return Filter::DoRender(update_sinks);
+  }
+
+  const GLComputeFunctions* compute = GetGLComputeFunctions();
+  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
+  for (auto& it : input_framebuffers_) {
+    int tex_idx = it.first;
+    GL_CALL(glActiveTexture(GL_TEXTURE0 + tex_idx));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D,
+                          it.second.frame_buffer->GetTexture()));
+    filter_program_->SetUniformValue(
+        tex_idx == 0 ? "inputImageTexture"
+                     : Util::StringFormat("inputImageTexture%d", tex_idx),
+        tex_idx);
+  }
+
+  // Same mapping the fragment path gets from the quad's texture coordinates
+  int width = framebuffer_->GetWidth();
+  int height = framebuffer_->GetHeight();
+  const float* coordinates =
+      GetTextureCoordinate(input_framebuffers_.begin()->second.rotation_mode);
+  filter_program_->SetUniformValue("textureCoordinateOrigin",
+                                   Vector2(coordinates[0], coordinates[1]));
+  filter_program_->SetUniformValue(
+      "textureCoordinateStepX",
+      Vector2((coordinates[2] - coordinates[0]) / width,
+              (coordinates[3] - coordinates[1]) / width));
+  filter_program_->SetUniformValue(
+      "textureCoordinateStepY",
+      Vector2((coordinates[4] - coordinates[0]) / height,
+              (coordinates[5] - coordinates[1]) / height));
+
+  // The image is declared without a format, it is bound in the one
+  // Filter::Render() allocated for output_format_
+  GLenum format = framebuffer_->GetTextureAttributes().internalFormat;
+  if (format == GL_RGBA) {
+    format = GL_RGBA8;
+  }
+  GL_CALL(compute->bind_image_texture(0, framebuffer_->GetTexture(), 0,
+                                      GL_FALSE, 0, GL_WRITE_ONLY, format));
+  GL_CALL(compute->dispatch_compute(
+      (width + kWorkGroupSize - 1) / kWorkGroupSize,
+      (height + kWorkGroupSize - 1) / kWorkGroupSize, 1));
+  // Sinks sample the result or render on top of it
+  GL_CALL(compute->memory_barrier(GL_TEXTURE_FETCH_BARRIER_BIT |
+                                  GL_FRAMEBUFFER_BARRIER_BIT |
+                                  GL_SHADER_IMAGE_ACCESS_BARRIER_BIT));
+
+  return Source::DoRender(update_sinks);
+}
+
+}  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/contrast_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 const std::string kContrastFragmentShaderString = R"(
@@ -57,4 +58,8 @@ bool ContrastFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string ContrastFilter::GetFingerprint() const {
+  return Util::StringFormat("ContrastFilter:%f", contrast_factor_);
+}
+
 }  // namespace gpupixel
@@ -104,6 +104,7 @@ DirectionalNonMaximumSuppressionFilter::Create() {
 bool DirectionalNonMaximumSuppressionFilter::Init() {
   if (InitWithFragmentShaderString(
           kDirectionalNonmaximumSuppressionFragmentShaderString)) {
+    SetOutputFormat(GPUPIXEL_FRAMEBUFFER_FORMAT_R8);
     texel_width_uniform_ = filter_program_->GetUniformLocation("texelWidth");
     texel_height_uniform_ = filter_program_->GetUniformLocation("texelHeight");
 
@@ -0,0 +1,249 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/filter/dual_kawase_blur_filter.h"
+#include <algorithm>
+#include "core/gpupixel_context.h"
+#include "utils/util.h"
+
+namespace gpupixel {
+
+#if defined(GPUPIXEL_GLES_SHADER)
+const std::string kDualKawaseDownFragmentShaderString = R"(
+    varying highp vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform highp vec2 halfPixel;
+
+    void main() {
+      highp vec2 uv = textureCoordinate;
+      lowp vec4 sum = texture2D(inputImageTexture, uv) * 4.0;
+      sum += texture2D(inputImageTexture, uv - halfPixel);
+      sum += texture2D(inputImageTexture, uv + halfPixel);
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x, -halfPixel.y));
+      sum += texture2D(inputImageTexture, uv - vec2(halfPixel.x, -halfPixel.y));
+      gl_FragColor = sum / 8.0;
+    })";
+
+const std::string kDualKawaseUpFragmentShaderString = R"(
+    varying highp vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform highp vec2 halfPixel;
+
+    void main() {
+      highp vec2 uv = textureCoordinate;
+      lowp vec4 sum = texture2D(inputImageTexture, uv + vec2(-halfPixel.x * 2.0, 0.0));
+      sum += texture2D(inputImageTexture, uv + vec2(-halfPixel.x, halfPixel.y)) * 2.0;
+      sum += texture2D(inputImageTexture, uv + vec2(0.0, halfPixel.y * 2.0));
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x, halfPixel.y)) * 2.0;
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x * 2.0, 0.0));
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x, -halfPixel.y)) * 2.0;
+      sum += texture2D(inputImageTexture, uv + vec2(0.0, -halfPixel.y * 2.0));
+      sum += texture2D(inputImageTexture, uv + vec2(-halfPixel.x, -halfPixel.y)) * 2.0;
+      gl_FragColor = sum / 12.0;
+    })";
+#elif defined(GPUPIXEL_GL_SHADER)
+const std::string kDualKawaseDownFragmentShaderString = R"(
+    varying vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform vec2 halfPixel;
+
+    void main() {
+      vec2 uv = textureCoordinate;
+      vec4 sum = texture2D(inputImageTexture, uv) * 4.0;
+      sum += texture2D(inputImageTexture, uv - halfPixel);
+      sum += texture2D(inputImageTexture, uv + halfPixel);
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x, -halfPixel.y));
+      sum += texture2D(inputImageTexture, uv - vec2(halfPixel.x, -halfPixel.y));
+      gl_FragColor = sum / 8.0;
+    })";
+
+const std::string kDualKawaseUpFragmentShaderString = R"(
+    varying vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform vec2 halfPixel;
+
+    void main() {
+      vec2 uv = textureCoordinate;
+      vec4 sum = texture2D(inputImageTexture, uv + vec2(-halfPixel.x * 2.0, 0.0));
+      sum += texture2D(inputImageTexture, uv + vec2(-halfPixel.x, halfPixel.y)) * 2.0;
+      sum += texture2D(inputImageTexture, uv + vec2(0.0, halfPixel.y * 2.0));
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x, halfPixel.y)) * 2.0;
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x * 2.0, 0.0));
+      sum += texture2D(inputImageTexture, uv + vec2(halfPixel.x, -halfPixel.y)) * 2.0;
+      sum += texture2D(inputImageTexture, uv + vec2(0.0, -halfPixel.y * 2.0));
+      sum += texture2D(inputImageTexture, uv + vec2(-halfPixel.x, -halfPixel.y)) * 2.0;
+      gl_FragColor = sum / 12.0;
+    })";
+#endif
+
+// One level of the pyramid. The output size is set by the owning group so
+// the upsample chain lands exactly on the sizes the downsample chain left,
+// including odd dimensions.
+class DualKawaseSampleFilter : public Filter {
+ public:
+  static std::shared_ptr<DualKawaseSampleFilter> Create(bool down) {
+    auto ret =
+        std::shared_ptr<DualKawaseSampleFilter>(new DualKawaseSampleFilter());
+    gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+      if (ret && !ret->InitWithFragmentShaderString(
+                     down ? kDualKawaseDownFragmentShaderString
+                          : kDualKawaseUpFragmentShaderString)) {
+        ret.reset();
+      }
+    });
+    return ret;
+  }
+
+  void SetOutputSize(int width, int height) {
+    output_width_ = width;
+    output_height_ = height;
+  }
+
+  void SetOffset(float offset) { offset_ = offset; }
+
+  bool GetOutputSize(int& width, int& height) const override {
+    if (input_framebuffers_.empty() || output_width_ <= 0 ||
+        output_height_ <= 0) {
+      return false;
+    }
+    width = output_width_;
+    height = output_height_;
+    return true;
+  }
+
+  bool DoRender(bool updateSinks = true) override {
+    // Offsets are in the input texture's own space, so no rotation handling
+    auto input = input_framebuffers_.begin()->second.frame_buffer;
+    filter_program_->SetUniformValue(
+        "halfPixel", Vector2(0.5 * offset_ / input->GetWidth(),
+                             0.5 * offset_ / input->GetHeight()));
+    return Filter::DoRender(updateSinks);
+  }
+
+ private:
+  DualKawaseSampleFilter() {}
+
+  int output_width_ = 0;
+  int output_height_ = 0;
+  float offset_ = 1.0;
+};
+
+DualKawaseBlurFilter::DualKawaseBlurFilter() {}
+
+DualKawaseBlurFilter::~DualKawaseBlurFilter() {}
+
+std::shared_ptr<DualKawaseBlurFilter> DualKawaseBlurFilter::Create(
+    int radius /* = 16*/) {
+  auto ret = std::shared_ptr<DualKawaseBlurFilter>(new DualKawaseBlurFilter());
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (ret && !ret->Init(radius)) {
+      ret.reset();
+    }
+  });
+  return ret;
+}
+
+bool DualKawaseBlurFilter::Init(int radius) {
+  if (!FilterGroup::Init()) {
+    return false;
+  }
+
+  // up_filters_[0] is the group's output for every iteration count, so
+  // sinks attached to the group survive radius changes
+  up_filters_.push_back(DualKawaseSampleFilter::Create(false));
+  SetTerminalFilter(up_filters_[0]);
+
+  SetRadius(radius);
+
+  RegisterProperty("radius", radius, "",
+                   [this](int& radius) { SetRadius(radius); });
+  return true;
+}
+
+void DualKawaseBlurFilter::SetRadius(int radius) {
+  radius = std::max(radius, 1);
+  if (radius == radius_) {
+    return;
+  }
+  radius_ = radius;
+
+  // n levels reach about 2^(n + 1) pixels, the offset covers what lies
+  // between two iteration counts
+  int iterations = 1;
+  while (iterations < kMaxIterations && (2 << iterations) < radius_) {
+    iterations++;
+  }
+  offset_ = std::min(std::max(radius_ / float(2 << iterations) * 2.0f, 0.5f),
+                     2.0f);
+
+  if (iterations != iterations_) {
+    iterations_ = iterations;
+    GPUPixelContext::GetInstance()->SyncRunWithContext([&] { UpdateChain(); });
+  }
+  for (auto& filter : down_filters_) {
+    filter->SetOffset(offset_);
+  }
+  for (auto& filter : up_filters_) {
+    filter->SetOffset(offset_);
+  }
+}
+
+std::string DualKawaseBlurFilter::GetFingerprint() const {
+  return Util::StringFormat("DualKawaseBlurFilter:%d", radius_);
+}
+
+void DualKawaseBlurFilter::UpdateChain() {
+  GraphEdit edit;
+  while ((int)down_filters_.size() < iterations_) {
+    down_filters_.push_back(DualKawaseSampleFilter::Create(true));
+  }
+  while ((int)up_filters_.size() < iterations_) {
+    up_filters_.push_back(DualKawaseSampleFilter::Create(false));
+  }
+
+  // Relink down[0] -> ... -> down[n-1] -> up[n-1] -> ... -> up[0]. The
+  // output filter keeps its sinks, everything else is rewired.
+  for (auto& filter : down_filters_) {
+    filter->RemoveAllSinks();
+  }
+  for (size_t i = 1; i < up_filters_.size(); i++) {
+    up_filters_[i]->RemoveAllSinks();
+  }
+  for (int i = 0; i + 1 < iterations_; i++) {
+    down_filters_[i]->AddSink(down_filters_[i + 1], 0);
+  }
+  down_filters_[iterations_ - 1]->AddSink(up_filters_[iterations_ - 1], 0);
+  for (int i = iterations_ - 1; i > 0; i--) {
+    up_filters_[i]->AddSink(up_filters_[i - 1], 0);
+  }
+
+  // Not AddFilter(), predicting the terminal would walk into our sinks
+  SetFilters({down_filters_[0]});
+  SetTerminalFilter(up_filters_[0]);
+}
+
+void DualKawaseBlurFilter::SetInputFramebuffer(
+    std::shared_ptr<GPUPixelFramebuffer> framebuffer,
+    RotationMode rotation_mode /* = NoRotation*/,
+    int texIdx /* = 0*/) {
+  if (framebuffer) {
+    int width = framebuffer->GetWidth();
+    int height = framebuffer->GetHeight();
+    if (rotationSwapsSize(rotation_mode)) {
+      std::swap(width, height);
+    }
+    for (int i = 0; i < iterations_; i++) {
+      up_filters_[i]->SetOutputSize(width, height);
+      width = std::max(1, (width + 1) / 2);
+      height = std::max(1, (height + 1) / 2);
+      down_filters_[i]->SetOutputSize(width, height);
+    }
+  }
+  FilterGroup::SetInputFramebuffer(framebuffer, rotation_mode, texIdx);
+}
+
+}  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/exposure_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 const std::string kExposureFragmentShaderString = R"(
@@ -56,4 +57,8 @@ bool ExposureFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string ExposureFilter::GetFingerprint() const {
+  return Util::StringFormat("ExposureFilter:%f", exposure_factor_);
+}
+
 }  // namespace gpupixel
@@ -195,26 +195,33 @@ bool FaceMakeupFilter::Init() {
 
   RegisterProperty("blend_level", 0,
                    "The smoothing of filter with range between -1 and 1.",
-                   [this](float& val) { SetBlendLevel(val); });
+                   [this](float& val) { blend_level_ = val; });
 
   std::vector<float> defaut;
   RegisterProperty("face_landmark", defaut,
                    "The face landmark of filter with range between -1 and 1.",
-                   [this](std::vector<float> val) { SetFaceLandmarks(val); });
+                   [this](std::vector<float>& val) {
+                     if (val.size() == 0) {
+                       has_face_ = false;
+                       return;
+                     }
+                     face_landmarks_.resize(val.size());
+                     for (size_t i = 0; i < val.size(); i++) {
+                       face_landmarks_[i] = 2 * val[i] - 1;
+                     }
+                     has_face_ = true;
+                   });
+  blend_level_property_ = GetPropertyHandle("blend_level");
+  face_landmark_property_ = GetPropertyHandle("face_landmark");
   return true;
 }
 
+void FaceMakeupFilter::SetBlendLevel(float level) {
+  SetProperty(blend_level_property_, level);
+}
+
 void FaceMakeupFilter::SetFaceLandmarks(std::vector<float> landmarks) {
-  if (landmarks.size() == 0) {
-    has_face_ = false;
-    return;
-  }
-  std::vector<float> vect;
-  for (auto it : landmarks) {
-    vect.push_back(2 * it - 1);
-  }
-  face_landmarks_ = vect;
-  has_face_ = true;
+  SetProperty(face_landmark_property_, landmarks);
 }
 
 void FaceMakeupFilter::SetImageTexture(std::shared_ptr<SourceImage> texture) {
@@ -227,16 +227,24 @@ bool FaceReshapeFilter::Init() {
   }
   RegisterProperty("thin_face", 0,
                    "The smoothing of filter with range between -1 and 1.",
-                   [this](float& val) { SetFaceSlimLevel(val); });
+                   [this](float& val) { thin_face_delta_ = val; });
 
   RegisterProperty("big_eye", 0,
                    "The smoothing of filter with range between -1 and 1.",
-                   [this](float& val) { SetEyeZoomLevel(val); });
+                   [this](float& val) { big_eye_delta_ = val; });
 
   std::vector<float> defaut;
   RegisterProperty("face_landmark", defaut,
                    "The face landmark of filter with range between -1 and 1.",
-                   [this](std::vector<float> val) { SetFaceLandmarks(val); });
+                   [this](std::vector<float>& val) {
+                     has_face_ = !val.empty();
+                     if (has_face_) {
+                       face_landmarks_ = val;
+                     }
+                   });
+  thin_face_property_ = GetPropertyHandle("thin_face");
+  big_eye_property_ = GetPropertyHandle("big_eye");
+  face_landmark_property_ = GetPropertyHandle("face_landmark");
 
   this->thin_face_delta_ = 0.0;
   // [0, 0.15]
@@ -245,13 +253,7 @@ bool FaceReshapeFilter::Init() {
 }
 
 void FaceReshapeFilter::SetFaceLandmarks(std::vector<float> landmarks) {
-  if (landmarks.size() == 0) {
-    has_face_ = false;
-    return;
-  }
-
-  face_landmarks_ = landmarks;
-  has_face_ = true;
+  SetProperty(face_landmark_property_, landmarks);
 }
 
 bool FaceReshapeFilter::DoRender(bool updateSinks) {
@@ -272,12 +274,12 @@ bool FaceReshapeFilter::DoRender(bool updateSinks) {
 
 #pragma mark - face slim
 void FaceReshapeFilter::SetFaceSlimLevel(float level) {
-  thin_face_delta_ = level;
+  SetProperty(thin_face_property_, level);
 }
 
 #pragma mark - eye zoom
 void FaceReshapeFilter::SetEyeZoomLevel(float level) {
-  big_eye_delta_ = level;
+  SetProperty(big_eye_property_, level);
 }
 
 }  // namespace gpupixel
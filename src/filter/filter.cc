@@ -23,40 +23,40 @@ init_filter_factory() {
   factory["BlusherFilter"] = BlusherFilter::Create;
   factory["FaceMakeupFilter"] = FaceMakeupFilter::Create;
 
-  // // Basic adjustment filters
-  // factory["ContrastFilter"] = ContrastFilter::Create;
-  // factory["ExposureFilter"] = ExposureFilter::Create;
-  // factory["SaturationFilter"] = SaturationFilter::Create;
-  // factory["RGBFilter"] = RGBFilter::Create;
-  // factory["HueFilter"] = HueFilter::Create;
-  // factory["HSBFilter"] = HSBFilter::Create;
-  // factory["ColorInvertFilter"] = ColorInvertFilter::Create;
-  // factory["WhiteBalanceFilter"] = WhiteBalanceFilter::Create;
-  // factory["ColorMatrixFilter"] = ColorMatrixFilter::Create;
-
-  // // Blur filters
-  // factory["IOSBlurFilter"] = IOSBlurFilter::Create;
-  // factory["BilateralFilter"] = BilateralFilter::Create;
-
-  // // Edge detection filters
-  // factory["SobelEdgeDetectionFilter"] = SobelEdgeDetectionFilter::Create;
-  // factory["CannyEdgeDetectionFilter"] = CannyEdgeDetectionFilter::Create;
-  // factory["DirectionalNonMaximumSuppressionFilter"] =
-  //     DirectionalNonMaximumSuppressionFilter::Create;
-  // factory["WeakPixelInclusionFilter"] = WeakPixelInclusionFilter::Create;
-
-  // // Special effect filters
-  // factory["ToonFilter"] = ToonFilter::Create;
-  // factory["SmoothToonFilter"] = SmoothToonFilter::Create;
-  // factory["PosterizeFilter"] = PosterizeFilter::Create;
-  // factory["PixellationFilter"] = PixellationFilter::Create;
-  // factory["SketchFilter"] = SketchFilter::Create;
-  // factory["GlassSphereFilter"] = GlassSphereFilter::Create;
-  // factory["SphereRefractionFilter"] = SphereRefractionFilter::Create;
-  // factory["EmbossFilter"] = EmbossFilter::Create;
-
-  // // Image processing filters
-  // factory["LuminanceRangeFilter"] = LuminanceRangeFilter::Create;
+  // Basic adjustment filters
+  factory["ContrastFilter"] = ContrastFilter::Create;
+  factory["ExposureFilter"] = ExposureFilter::Create;
+  factory["SaturationFilter"] = SaturationFilter::Create;
+  factory["RGBFilter"] = RGBFilter::Create;
+  factory["HueFilter"] = HueFilter::Create;
+  factory["HSBFilter"] = HSBFilter::Create;
+  factory["ColorInvertFilter"] = ColorInvertFilter::Create;
+  factory["WhiteBalanceFilter"] = WhiteBalanceFilter::Create;
+  factory["ColorMatrixFilter"] = ColorMatrixFilter::Create;
+
+  // Blur filters
+  factory["IOSBlurFilter"] = IOSBlurFilter::Create;
+  factory["BilateralFilter"] = BilateralFilter::Create;
+
+  // Edge detection filters
+  factory["SobelEdgeDetectionFilter"] = SobelEdgeDetectionFilter::Create;
+  factory["CannyEdgeDetectionFilter"] = CannyEdgeDetectionFilter::Create;
+  factory["DirectionalNonMaximumSuppressionFilter"] =
+      DirectionalNonMaximumSuppressionFilter::Create;
+  factory["WeakPixelInclusionFilter"] = WeakPixelInclusionFilter::Create;
+
+  // Special effect filters
+  factory["ToonFilter"] = ToonFilter::Create;
+  factory["SmoothToonFilter"] = SmoothToonFilter::Create;
+  factory["PosterizeFilter"] = PosterizeFilter::Create;
+  factory["PixellationFilter"] = PixellationFilter::Create;
+  factory["SketchFilter"] = SketchFilter::Create;
+  factory["GlassSphereFilter"] = GlassSphereFilter::Create;
+  factory["SphereRefractionFilter"] = SphereRefractionFilter::Create;
+  factory["EmbossFilter"] = EmbossFilter::Create;
+
+  // Image processing filters
+  factory["LuminanceRangeFilter"] = LuminanceRangeFilter::Create;
 
   return factory;
 }
@@ -86,6 +86,23 @@ std::shared_ptr<Filter> Filter::Create(const std::string& filter_class_name) {
   return nullptr;
 }
 
+std::future<bool> Filter::WarmUp(
+    const std::vector<std::string>& filter_class_names) {
+  // One task per filter, frames in between don't wait for the whole list
+  std::vector<std::function<bool()>> builds;
+  for (const auto& name : filter_class_names) {
+    builds.push_back([name] {
+      // Dropped at once, its programs are kept by the context
+      if (!Create(name)) {
+        LOG_WARN("Filter: can't warm up unknown filter {}", name);
+        return false;
+      }
+      return true;
+    });
+  }
+  return GPUPixelContext::GetInstance()->WarmUpPrograms(builds);
+}
+
 std::shared_ptr<Filter> Filter::CreateWithShaderString(
     const std::string& vertex_shader_source,
     const std::string& fragment_shader_source) {
@@ -110,6 +127,9 @@ bool Filter::InitWithShaderString(const std::string& vertex_shader_source,
   input_count_ = input_number;
   filter_program_ = GPUPixelGLProgram::CreateWithShaderString(
       vertex_shader_source, fragment_shader_source);
+  if (!filter_program_) {
+    return false;
+  }
   filter_position_attribute_ = filter_program_->GetAttribLocation("position");
   GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
   GL_CALL(glEnableVertexAttribArray(filter_position_attribute_));
@@ -262,74 +282,91 @@ const float* Filter::GetTextureCoordinate(
 }
 
 void Filter::Render() {
-  if (input_framebuffers_.empty()) {
+  ApplyPendingProperties();
+
+  int width = 0;
+  int height = 0;
+  if (!GetOutputSize(width, height)) {
     return;
   }
+  TextureAttributes attributes =
+      GPUPixelFramebuffer::GetFormatTextureAttributes(output_format_);
+  if (!framebuffer_ ||
+      (framebuffer_->GetWidth() != width ||
+       framebuffer_->GetHeight() != height ||
+       framebuffer_->GetTextureAttributes().internalFormat !=
+           attributes.internalFormat)) {
+    framebuffer_ = GPUPixelContext::GetInstance()
+                       ->GetFramebufferFactory()
+                       ->CreateFramebuffer(width, height, false, attributes);
+  }
+  DoRender(true);
+}
+
+bool Filter::GetOutputSize(int& width, int& height) const {
+  if (input_framebuffers_.empty()) {
+    return false;
+  }
 
   std::shared_ptr<GPUPixelFramebuffer> first_input_framebuffer =
       input_framebuffers_.begin()->second.frame_buffer;
   RotationMode first_input_rotation =
       input_framebuffers_.begin()->second.rotation_mode;
   if (!first_input_framebuffer) {
-    return;
+    return false;
   }
 
-  int rotated_framebuffer_width = first_input_framebuffer->GetWidth();
-  int rotated_framebuffer_height = first_input_framebuffer->GetHeight();
+  width = first_input_framebuffer->GetWidth();
+  height = first_input_framebuffer->GetHeight();
   if (rotationSwapsSize(first_input_rotation)) {
-    rotated_framebuffer_width = first_input_framebuffer->GetHeight();
-    rotated_framebuffer_height = first_input_framebuffer->GetWidth();
+    std::swap(width, height);
   }
 
   if (framebuffer_scale_ != 1.0) {
-    rotated_framebuffer_width =
-        int(rotated_framebuffer_width * framebuffer_scale_);
-    rotated_framebuffer_height =
-        int(rotated_framebuffer_height * framebuffer_scale_);
-  }
-  if (!framebuffer_ ||
-      (framebuffer_->GetWidth() != rotated_framebuffer_width ||
-       framebuffer_->GetHeight() != rotated_framebuffer_height)) {
-    framebuffer_ = GPUPixelContext::GetInstance()
-                       ->GetFramebufferFactory()
-                       ->CreateFramebuffer(rotated_framebuffer_width,
-                                           rotated_framebuffer_height);
+    width = int(width * framebuffer_scale_);
+    height = int(height * framebuffer_scale_);
   }
-  DoRender(true);
+  return true;
 }
 
-bool Filter::RegisterProperty(
+template <typename T>
+bool Filter::RegisterTypedProperty(
+    std::map<std::string, TypedProperty<T>>& properties,
     const std::string& name,
-    int default_value,
-    const std::string& comment /* = ""*/,
-    std::function<void(int&)> on_property_set_func /* = 0*/) {
+    const std::string& type,
+    const T& default_value,
+    const std::string& comment,
+    std::function<void(T&)> on_property_set_func) {
   if (HasProperty(name)) {
     return false;
   }
-  IntProperty property;
-  property.type = "int";
+  TypedProperty<T>& property = properties[name];
+  property.type = type;
   property.value = default_value;
+  property.staged.Reset(default_value);
   property.comment = comment;
   property.on_property_set_func = on_property_set_func;
-  int_properties_[name] = property;
+  property.handle = static_cast<PropertyHandle>(property_handles_.size());
+  property_handles_.push_back(&property);
   return true;
 }
 
+bool Filter::RegisterProperty(
+    const std::string& name,
+    int default_value,
+    const std::string& comment /* = ""*/,
+    std::function<void(int&)> on_property_set_func /* = 0*/) {
+  return RegisterTypedProperty(int_properties_, name, "int", default_value,
+                               comment, on_property_set_func);
+}
+
 bool Filter::RegisterProperty(
     const std::string& name,
     float default_value,
     const std::string& comment /* = ""*/,
     std::function<void(float&)> on_property_set_func /* = 0*/) {
-  if (HasProperty(name)) {
-    return false;
-  }
-  FloatProperty property;
-  property.type = "float";
-  property.value = default_value;
-  property.comment = comment;
-  property.on_property_set_func = on_property_set_func;
-  float_properties_[name] = property;
-  return true;
+  return RegisterTypedProperty(float_properties_, name, "float", default_value,
+                               comment, on_property_set_func);
 }
 
 bool Filter::RegisterProperty(
@@ -337,16 +374,9 @@ bool Filter::RegisterProperty(
     std::vector<float> default_value,
     const std::string& comment /* = ""*/,
     std::function<void(std::vector<float>&)> on_property_set_func /* = 0*/) {
-  if (HasProperty(name)) {
-    return false;
-  }
-  VectorProperty property;
-  property.type = "vector";
-  property.value = default_value;
-  property.comment = comment;
-  property.on_property_set_func = on_property_set_func;
-  vector_properties_[name] = property;
-  return true;
+  return RegisterTypedProperty(vector_properties_, name, "vector",
+                               default_value, comment,
+                               on_property_set_func);
 }
 
 bool Filter::RegisterProperty(
@@ -354,119 +384,142 @@ bool Filter::RegisterProperty(
     const std::string& default_value,
     const std::string& comment /* = ""*/,
     std::function<void(std::string&)> on_property_set_func /* = 0*/) {
-  if (HasProperty(name)) {
+  return RegisterTypedProperty(string_properties_, name, "string",
+                               default_value, comment,
+                               on_property_set_func);
+}
+
+template <typename T>
+bool Filter::StageProperty(Property* property,
+                           const std::string& type,
+                           const T& value) {
+  if (!property) {
+    return false;
+  } else if (property->type != type) {
+    LOG_WARN("Filter::setProperty The property type is expected to be {}",
+             property->type);
     return false;
   }
-  StringProperty property;
-  property.type = "string";
-  property.value = default_value;
-  property.comment = comment;
-  property.on_property_set_func = on_property_set_func;
-  string_properties_[name] = property;
+  ((TypedProperty<T>*)property)->staged.Write(value);
+  has_pending_properties_.store(true, std::memory_order_release);
   return true;
 }
 
 bool Filter::SetProperty(const std::string& name, int value) {
-  Property* raw_property = GetProperty(name);
-  if (!raw_property) {
+  Property* property = GetProperty(name);
+  if (!property) {
     LOG_WARN("Filter::setProperty invalid property {}", name);
-    return false;
-  } else if (raw_property->type != "int") {
-    LOG_WARN("Filter::setProperty The property type is expected to be {}",
-             raw_property->type);
-    return false;
-  }
-  IntProperty* property = ((IntProperty*)raw_property);
-  property->value = value;
-  if (property->on_property_set_func) {
-    property->on_property_set_func(value);
   }
-  return true;
+  return StageProperty(property, "int", value);
 }
 
 bool Filter::SetProperty(const std::string& name, float value) {
-  Property* raw_property = GetProperty(name);
-  if (!raw_property) {
+  Property* property = GetProperty(name);
+  if (!property) {
     LOG_WARN("Filter::setProperty invalid property {}", name);
-    return false;
-  } else if (raw_property->type != "float") {
-    LOG_WARN("Filter::setProperty The property type is expected to be {}",
-             raw_property->type);
-    return false;
   }
-  FloatProperty* property = ((FloatProperty*)raw_property);
-  if (property->on_property_set_func) {
-    property->on_property_set_func(value);
-  }
-  property->value = value;
-
-  return true;
+  return StageProperty(property, "float", value);
 }
 
 bool Filter::SetProperty(const std::string& name, std::vector<float> value) {
-  Property* raw_property = GetProperty(name);
-  if (!raw_property) {
+  Property* property = GetProperty(name);
+  if (!property) {
     LOG_WARN("Filter::setProperty invalid property {}", name);
-    return false;
-  } else if (raw_property->type != "vector") {
-    LOG_WARN("Filter::setProperty The property type is expected to be {}",
-             raw_property->type);
-    return false;
-  }
-  VectorProperty* property = ((VectorProperty*)raw_property);
-  if (property->on_property_set_func) {
-    property->on_property_set_func(value);
   }
-  property->value = value;
-
-  return true;
+  return StageProperty(property, "vector", value);
 }
 
 bool Filter::SetProperty(const std::string& name, std::string value) {
-  Property* raw_property = GetProperty(name);
-  if (!raw_property) {
+  Property* property = GetProperty(name);
+  if (!property) {
     LOG_WARN("Filter::setProperty invalid property {}", name);
-    return false;
-  } else if (raw_property->type != "string") {
-    LOG_WARN("Filter::setProperty The property type is expected to be {}",
-             raw_property->type);
-    return false;
   }
-  StringProperty* property = ((StringProperty*)raw_property);
-  property->value = value;
-  if (property->on_property_set_func) {
-    property->on_property_set_func(value);
+  return StageProperty(property, "string", value);
+}
+
+Filter::PropertyHandle Filter::GetPropertyHandle(
+    const std::string& name) const {
+  Property* property = const_cast<Filter*>(this)->GetProperty(name);
+  return property ? property->handle : kInvalidPropertyHandle;
+}
+
+bool Filter::SetProperty(PropertyHandle handle, int value) {
+  Property* property = GetProperty(handle);
+  if (!property) {
+    LOG_WARN("Filter::setProperty invalid property handle {}", handle);
+  }
+  return StageProperty(property, "int", value);
+}
+
+bool Filter::SetProperty(PropertyHandle handle, float value) {
+  Property* property = GetProperty(handle);
+  if (!property) {
+    LOG_WARN("Filter::setProperty invalid property handle {}", handle);
+  }
+  return StageProperty(property, "float", value);
+}
+
+bool Filter::SetProperty(PropertyHandle handle,
+                         const std::vector<float>& value) {
+  Property* property = GetProperty(handle);
+  if (!property) {
+    LOG_WARN("Filter::setProperty invalid property handle {}", handle);
+  }
+  return StageProperty(property, "vector", value);
+}
+
+bool Filter::SetProperty(PropertyHandle handle, const std::string& value) {
+  Property* property = GetProperty(handle);
+  if (!property) {
+    LOG_WARN("Filter::setProperty invalid property handle {}", handle);
+  }
+  return StageProperty(property, "string", value);
+}
+
+void Filter::ApplyPendingProperties() {
+  // Cleared before the scan, a value staged meanwhile is seen next frame
+  if (!has_pending_properties_.exchange(false, std::memory_order_acquire)) {
+    return;
+  }
+  for (Property* property : property_handles_) {
+    property->ApplyPending();
   }
-  return true;
 }
 
 bool Filter::GetProperty(const std::string& name, int& ret_value) {
   Property* property = GetProperty(name);
-  if (!property) {
+  if (!property || property->type != "int") {
     return false;
   }
-  ret_value = ((IntProperty*)property)->value;
+  ret_value = ((IntProperty*)property)->staged.Latest();
   return true;
 }
 
 bool Filter::GetProperty(const std::string& name, float& ret_value) {
   Property* property = GetProperty(name);
-  if (!property) {
+  if (!property || property->type != "float") {
     return false;
   }
-  ret_value = ((FloatProperty*)property)->value;
+  ret_value = ((FloatProperty*)property)->staged.Latest();
   return true;
 }
 
 bool Filter::GetProperty(const std::string& name, std::string& ret_value) {
   Property* property = GetProperty(name);
-  if (!property) {
+  if (!property || property->type != "string") {
     return false;
   }
-  ret_value = ((StringProperty*)property)->value;
+  ret_value = ((StringProperty*)property)->staged.Latest();
   return true;
 }
 
+Filter::Property* Filter::GetProperty(PropertyHandle handle) {
+  if (handle < 0 || handle >= (PropertyHandle)property_handles_.size()) {
+    return nullptr;
+  }
+  return property_handles_[handle];
+}
+
 Filter::Property* Filter::GetProperty(const std::string& name) {
   if (int_properties_.find(name) != int_properties_.end()) {
     return &int_properties_[name];
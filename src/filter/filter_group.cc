@@ -8,7 +8,11 @@
 #include "gpupixel/filter/filter_group.h"
 #include <assert.h>
 #include <algorithm>
+#include <typeinfo>
 #include "core/gpupixel_context.h"
+#include "core/gpupixel_graph_snapshot.h"
+#include "utils/logging.h"
+#include "utils/util.h"
 
 namespace gpupixel {
 
@@ -16,7 +20,7 @@ FilterGroup::FilterGroup() : terminal_filter_(0) {}
 
 FilterGroup::~FilterGroup() {
   RemoveAllFilters();
-  terminal_filter_ = 0;
+  SetTerminalFilter(nullptr);
 }
 
 std::shared_ptr<FilterGroup> FilterGroup::Create() {
@@ -48,14 +52,16 @@ bool FilterGroup::Init(std::vector<std::shared_ptr<Filter>> filters) {
   if (filters.size() == 0) {
     return true;
   }
-  filters_ = filters;
+  SetFilters(filters);
+  finalized_ = false;
   SetTerminalFilter(PredictTerminalFilter(filters[filters.size() - 1]));
   return true;
 }
 
 bool FilterGroup::HasFilter(const std::shared_ptr<Filter> filter) const {
-  auto it = std::find(filters_.begin(), filters_.end(), filter);
-  if (it != filters_.end()) {
+  auto filters = GraphSnapshot::Current()->GetFilters(this);
+  auto it = std::find(filters->begin(), filters->end(), filter);
+  if (it != filters->end()) {
     return true;
   } else {
     return false;
@@ -67,34 +73,91 @@ void FilterGroup::AddFilter(std::shared_ptr<Filter> filter) {
     return;
   }
 
-  filters_.push_back(filter);
+  AppendFilter(filter);
+  // Cleared once published, a Finalize() running meanwhile saw the old list
+  finalized_ = false;
   SetTerminalFilter(PredictTerminalFilter(filter));
 }
 
 void FilterGroup::RemoveFilter(std::shared_ptr<Filter> filter) {
-  auto itr = std::find(filters_.begin(), filters_.end(), filter);
-  if (itr != filters_.end()) {
-    filters_.erase(itr);
-  }
+  // The removed filter may be standing in for merged ones, the render thread
+  // sees them restored and it gone at once
+  GraphEdit edit;
+  UndoMerges(false);
+  EraseFilter(filter);
+  finalized_ = false;
 }
 
 void FilterGroup::RemoveAllFilters() {
-  filters_.clear();
+  {
+    std::unique_lock<std::mutex> lock(merge_mutex_);
+    merged_filters_.clear();
+    merge_report_.clear();
+  }
+  SetFilters({});
+  finalized_ = false;
+}
+
+std::vector<std::shared_ptr<Filter>> FilterGroup::GetFilters() const {
+  return *GraphSnapshot::Current()->GetFilters(this);
+}
+
+void FilterGroup::SetFilters(std::vector<std::shared_ptr<Filter>> filters) {
+  const FilterGroup* self = this;
+  auto list =
+      std::make_shared<const GraphSnapshot::FilterList>(std::move(filters));
+  GraphSnapshot::Edit(
+      [self, list](GraphSnapshot& graph) { graph.SetFilters(self, list); });
+}
+
+void FilterGroup::AppendFilter(std::shared_ptr<Filter> filter) {
+  const FilterGroup* self = this;
+  GraphSnapshot::Edit([self, filter](GraphSnapshot& graph) {
+    auto filters = graph.GetFilters(self);
+    if (std::find(filters->begin(), filters->end(), filter) !=
+        filters->end()) {
+      return;
+    }
+    auto next = std::make_shared<GraphSnapshot::FilterList>(*filters);
+    next->push_back(filter);
+    graph.SetFilters(self, next);
+  });
+}
+
+void FilterGroup::EraseFilter(std::shared_ptr<Filter> filter) {
+  const FilterGroup* self = this;
+  GraphSnapshot::Edit([self, filter](GraphSnapshot& graph) {
+    auto filters = graph.GetFilters(self);
+    auto it = std::find(filters->begin(), filters->end(), filter);
+    if (it == filters->end()) {
+      return;
+    }
+    auto next = std::make_shared<GraphSnapshot::FilterList>(*filters);
+    next->erase(next->begin() + (it - filters->begin()));
+    graph.SetFilters(self, next);
+  });
+}
+
+std::vector<std::string> FilterGroup::GetMergeReport() const {
+  std::unique_lock<std::mutex> lock(merge_mutex_);
+  return merge_report_;
 }
 
 std::shared_ptr<Filter> FilterGroup::PredictTerminalFilter(
     std::shared_ptr<Filter> filter) {
-  if (filter->GetSinks().size() == 0) {
+  auto sinks = filter->GetSinks();
+  if (sinks->size() == 0) {
     return filter;
   } else {
     return PredictTerminalFilter(
-        std::dynamic_pointer_cast<Filter>(filter->GetSinks().begin()->first));
+        std::dynamic_pointer_cast<Filter>(sinks->begin()->first));
   }
 }
 
 std::shared_ptr<Source> FilterGroup::AddSink(std::shared_ptr<Sink> sink) {
-  if (terminal_filter_) {
-    return terminal_filter_->AddSink(sink);
+  auto terminal_filter = GetTerminalFilter();
+  if (terminal_filter) {
+    return terminal_filter->AddSink(sink);
   } else {
     return 0;
   }
@@ -102,46 +165,168 @@ std::shared_ptr<Source> FilterGroup::AddSink(std::shared_ptr<Sink> sink) {
 
 std::shared_ptr<Source> FilterGroup::AddSink(std::shared_ptr<Sink> sink,
                                              int inputNumber) {
-  if (terminal_filter_) {
-    return terminal_filter_->AddSink(sink, inputNumber);
+  auto terminal_filter = GetTerminalFilter();
+  if (terminal_filter) {
+    return terminal_filter->AddSink(sink, inputNumber);
   } else {
     return 0;
   }
 }
 
 void FilterGroup::RemoveSink(std::shared_ptr<Sink> sink) {
-  if (terminal_filter_) {
-    terminal_filter_->RemoveSink(sink);
+  auto terminal_filter = GetTerminalFilter();
+  if (terminal_filter) {
+    terminal_filter->RemoveSink(sink);
   }
 }
 
 void FilterGroup::RemoveAllSinks() {
-  if (terminal_filter_) {
-    terminal_filter_->RemoveAllSinks();
+  auto terminal_filter = GetTerminalFilter();
+  if (terminal_filter) {
+    terminal_filter->RemoveAllSinks();
   }
 }
 
 bool FilterGroup::HasSink(const std::shared_ptr<Sink> sink) const {
-  if (terminal_filter_) {
-    return terminal_filter_->HasSink(sink);
+  auto terminal_filter = GetTerminalFilter();
+  if (terminal_filter) {
+    return terminal_filter->HasSink(sink);
   } else {
     return false;
   }
 }
 
-std::map<std::shared_ptr<Sink>, int>& FilterGroup::GetSinks() {
-  assert(terminal_filter_);
-  return terminal_filter_->GetSinks();
+std::shared_ptr<const Source::SinkMap> FilterGroup::GetSinks() const {
+  auto terminal_filter = GetTerminalFilter();
+  assert(terminal_filter);
+  return terminal_filter->GetSinks();
 }
 
 bool FilterGroup::DoRender(bool updateSinks) {
   return true;
 }
 
+void FilterGroup::Finalize() {
+  std::unique_lock<std::mutex> lock(merge_mutex_);
+  finalized_ = true;
+  // The render thread sees all merges at once
+  GraphEdit edit;
+
+  std::vector<EntryFilter> entries;
+  CollectEntryFilters(nullptr, entries);
+  for (auto& entry : entries) {
+    entry.filter->ApplyPendingProperties();
+  }
+
+  std::map<std::string, std::shared_ptr<Filter>> canonical;
+  for (auto& entry : entries) {
+    std::string key = GetMergeKey(*entry.filter);
+    if (key.empty()) {
+      continue;
+    }
+    auto it = canonical.find(key);
+    if (it == canonical.end()) {
+      canonical[key] = entry.filter;
+      continue;
+    }
+
+    // A group's output filter can't be dropped from it
+    FilterGroup* owner = entry.owner ? entry.owner.get() : this;
+    if (entry.filter == owner->GetTerminalFilter()) {
+      continue;
+    }
+
+    MergedFilter merged;
+    merged.owner = entry.owner;
+    merged.filter = entry.filter;
+    merged.replacement = it->second;
+    merged.sinks = *entry.filter->GetSinks();
+    entry.filter->RemoveAllSinks();
+    for (auto& sink : merged.sinks) {
+      merged.replacement->AddSink(sink.first, sink.second);
+    }
+    owner->EraseFilter(entry.filter);
+    merged.report = Util::StringFormat("%s merged, %d sink(s) moved",
+                                       typeid(*entry.filter).name(),
+                                       (int)merged.sinks.size());
+    LOG_INFO("FilterGroup: {}", merged.report);
+    merged_filters_.push_back(merged);
+  }
+
+  // Merges undone since the last run drop out, those kept stay listed
+  merge_report_.clear();
+  for (auto& merged : merged_filters_) {
+    merge_report_.push_back(merged.report);
+  }
+}
+
+std::string FilterGroup::GetMergeKey(const Filter& filter) {
+  std::string fingerprint = filter.GetFingerprint();
+  if (fingerprint.empty()) {
+    return fingerprint;
+  }
+  // Same texels stored in another format or at another size are not
+  // interchangeable
+  return fingerprint + Util::StringFormat("@%d@%g",
+                                          (int)filter.GetOutputFormat(),
+                                          filter.GetFramebufferScale());
+}
+
+void FilterGroup::CollectEntryFilters(std::shared_ptr<FilterGroup> self,
+                                      std::vector<EntryFilter>& entries) {
+  auto filters = GraphSnapshot::Current()->GetFilters(this);
+  for (auto& filter : *filters) {
+    entries.push_back({self, filter});
+    // A group with a fingerprint is merged as a whole, not looked into
+    auto group = std::dynamic_pointer_cast<FilterGroup>(filter);
+    if (group && filter->GetFingerprint().empty()) {
+      group->CollectEntryFilters(group, entries);
+    }
+  }
+}
+
+void FilterGroup::UndoMerges(bool diverged_only) {
+  std::unique_lock<std::mutex> lock(merge_mutex_);
+  if (merged_filters_.empty()) {
+    return;
+  }
+  GraphEdit edit;
+  for (auto it = merged_filters_.begin(); it != merged_filters_.end();) {
+    if (diverged_only) {
+      // A merged filter doesn't render, values set on it are only seen here.
+      // Restored ones apply theirs once they render again.
+      it->filter->ApplyPendingProperties();
+      it->replacement->ApplyPendingProperties();
+      if (GetMergeKey(*it->filter) == GetMergeKey(*it->replacement)) {
+        ++it;
+        continue;
+      }
+    }
+    for (auto& sink : it->sinks) {
+      it->replacement->RemoveSink(sink.first);
+      it->filter->AddSink(sink.first, sink.second);
+    }
+    FilterGroup* owner = it->owner ? it->owner.get() : this;
+    owner->AppendFilter(it->filter);
+    LOG_INFO("FilterGroup: merge of {} undone", typeid(*it->filter).name());
+    it = merged_filters_.erase(it);
+    // It may match another filter now
+    finalized_ = false;
+  }
+}
+
 void FilterGroup::Render() {
+  // Already done when the input arrived, kept for groups rendered without
+  ApplyPendingProperties();
+
+  if (!finalized_) {
+    Finalize();
+  }
+
   DoRender();
 
-  for (auto& filter : filters_) {
+  auto filters = GraphSnapshot::Current()->GetFilters(this);
+  for (auto& filter : *filters) {
     if (filter->IsReady()) {
       filter->Render();
     }
@@ -149,8 +334,9 @@ void FilterGroup::Render() {
 }
 
 void FilterGroup::DoUpdateSinks() {
-  if (terminal_filter_) {
-    terminal_filter_->DoUpdateSinks();
+  auto terminal_filter = GetTerminalFilter();
+  if (terminal_filter) {
+    terminal_filter->DoUpdateSinks();
   }
 }
 
@@ -171,7 +357,13 @@ void FilterGroup::SetInputFramebuffer(
     std::shared_ptr<GPUPixelFramebuffer> framebuffer,
     RotationMode rotation_mode /* = NoRotation*/,
     int texIdx /* = 0*/) {
-  for (auto& filter : filters_) {
+  // Before the broadcast, properties like blur_engine rewire the members
+  // and the new ones need this frame's input too
+  ApplyPendingProperties();
+  // Likewise, so an unmerged filter gets this frame's input
+  UndoMerges(true);
+  auto filters = GraphSnapshot::Current()->GetFilters(this);
+  for (auto& filter : *filters) {
     filter->SetInputFramebuffer(framebuffer, rotation_mode, texIdx);
   }
 }
@@ -184,6 +376,14 @@ bool FilterGroup::IsReady() const {
   return true;
 }
 
+void FilterGroup::ApplyPendingProperties() {
+  Filter::ApplyPendingProperties();
+  auto filters = GraphSnapshot::Current()->GetFilters(this);
+  for (auto& filter : *filters) {
+    filter->ApplyPendingProperties();
+  }
+}
+
 void FilterGroup::ResetAndClean() {
   // for (auto& filter : filters_) {
   //    filter->unPrepeared();
@@ -33,6 +33,7 @@ bool GaussianBlurFilter::Init(int radius, float sigma) {
     return false;
   }
 
+  radius_ = radius;
   horizontal_blur_filter_ = GaussianBlurMonoFilter::Create(
       GaussianBlurMonoFilter::HORIZONTAL, radius, sigma);
   vertical_blur_filter_ = GaussianBlurMonoFilter::Create(
@@ -44,17 +45,68 @@ bool GaussianBlurFilter::Init(int radius, float sigma) {
 
   RegisterProperty("sigma", 2.0, "", [this](float& sigma) { setSigma(sigma); });
 
+  RegisterProperty("blur_engine", SEPARABLE,
+                   "0 for the separable Gaussian, 1 for the pyramid blur.",
+                   [this](int& engine) {
+                     SetBlurEngine(engine == PYRAMID ? PYRAMID : SEPARABLE);
+                   });
+
   return true;
 }
 
 void GaussianBlurFilter::SetRadius(int radius) {
+  radius_ = radius;
   horizontal_blur_filter_->SetRadius(radius);
   vertical_blur_filter_->SetRadius(radius);
+  if (pyramid_blur_filter_) {
+    pyramid_blur_filter_->SetRadius(radius);
+  }
 }
 
 void GaussianBlurFilter::setSigma(float sigma) {
   horizontal_blur_filter_->setSigma(sigma);
   vertical_blur_filter_->setSigma(sigma);
+  radius_ = GaussianBlurMonoFilter::RadiusForSigma(sigma);
+  if (pyramid_blur_filter_) {
+    pyramid_blur_filter_->SetRadius(radius_);
+  }
+}
+
+std::string GaussianBlurFilter::GetFingerprint() const {
+  if (engine_ == PYRAMID) {
+    return "GaussianBlurFilter{" + pyramid_blur_filter_->GetFingerprint() + "}";
+  }
+  return "GaussianBlurFilter{" + horizontal_blur_filter_->GetFingerprint() +
+         "," + vertical_blur_filter_->GetFingerprint() + "}";
+}
+
+void GaussianBlurFilter::SetBlurEngine(BlurEngine engine) {
+  if (engine == engine_) {
+    return;
+  }
+  engine_ = engine;
+
+  GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (engine_ == PYRAMID && !pyramid_blur_filter_) {
+      pyramid_blur_filter_ =
+          DualKawaseBlurFilter::Create(radius_);
+    }
+
+    // Move our sinks over to the new output filter
+    GraphEdit edit;
+    auto sinks = GetTerminalFilter()->GetSinks();
+    GetTerminalFilter()->RemoveAllSinks();
+    if (engine_ == PYRAMID) {
+      SetFilters({pyramid_blur_filter_});
+      SetTerminalFilter(pyramid_blur_filter_);
+    } else {
+      SetFilters({horizontal_blur_filter_});
+      SetTerminalFilter(vertical_blur_filter_);
+    }
+    for (auto& it : *sinks) {
+      GetTerminalFilter()->AddSink(it.first, it.second);
+    }
+  });
 }
 
 }  // namespace gpupixel
@@ -6,13 +6,32 @@
  */
 
 #include "gpupixel/filter/gaussian_blur_mono_filter.h"
+#include <algorithm>
 #include <cmath>
+#include <typeinfo>
 #include "core/gpupixel_context.h"
+#include "utils/logging.h"
 #include "utils/util.h"
 namespace gpupixel {
 
+namespace {
+// Bucket programs by their sources, shared by every blur filter instance.
+// GL thread only. Leaked, filters may be destroyed by static destructors.
+std::map<std::string, std::weak_ptr<GPUPixelGLProgram>>& SharedPrograms() {
+  static auto* programs =
+      new std::map<std::string, std::weak_ptr<GPUPixelGLProgram>>();
+  return *programs;
+}
+}  // namespace
+
 GaussianBlurMonoFilter::GaussianBlurMonoFilter(Type type /* = HORIZONTAL*/)
-    : type_(type), radius_(4), sigma_(2.0) {}
+    : type_(type), radius_(4), sigma_(2.0) {
+  // Registered here so that subclasses with their own Init() have them too
+  RegisterProperty("radius", radius_, "Blur radius in pixels",
+                   [this](int& radius) { ApplyRadius(radius); });
+  RegisterProperty("sigma", sigma_, "Gaussian sigma, sets the radius",
+                   [this](float& sigma) { ApplySigma(sigma); });
+}
 
 std::shared_ptr<GaussianBlurMonoFilter> GaussianBlurMonoFilter::Create(
     Type type /* = HORIZONTAL*/,
@@ -28,207 +47,146 @@ std::shared_ptr<GaussianBlurMonoFilter> GaussianBlurMonoFilter::Create(
   return ret;
 }
 
-bool GaussianBlurMonoFilter::Init(int radius, float sigma) {
-  if (Filter::InitWithShaderString(
-          GenerateOptimizedVertexShaderString(radius, sigma),
-          GenerateOptimizedFragmentShaderString(radius, sigma))) {
-    return true;
+GaussianBlurMonoFilter::~GaussianBlurMonoFilter() {
+  for (auto& it : bucket_programs_) {
+    if (it.second.get() == filter_program_) {
+      filter_program_ = 0;
+    }
   }
-  return false;
+  bucket_programs_.clear();
 }
 
-void GaussianBlurMonoFilter::SetRadius(int radius) {
-  if (radius == radius_) {
-    return;
-  }
-
+bool GaussianBlurMonoFilter::Init(int radius, float sigma) {
+  input_count_ = 1;
   radius_ = radius;
+  sigma_ = sigma;
+  UpdateBlurProgram();
+  return filter_program_ != 0;
+}
 
-  if (filter_program_) {
-    delete filter_program_;
-    filter_program_ = 0;
-  }
-  InitWithShaderString(GenerateOptimizedVertexShaderString(radius_, sigma_),
-                       GenerateOptimizedFragmentShaderString(radius_, sigma_));
+void GaussianBlurMonoFilter::SetRadius(int radius) {
+  SetProperty("radius", radius);
 }
 
 void GaussianBlurMonoFilter::setSigma(float sigma) {
-  if (sigma == sigma_) {
-    return;
-  }
-
-  sigma_ = round(sigma);
+  SetProperty("sigma", sigma);
+}
 
+int GaussianBlurMonoFilter::RadiusForSigma(float sigma) {
   int calculatedSampleRadius = 0;
-  if (sigma_ >= 1)  // Avoid a divide-by-zero error here
+  if (sigma >= 1)  // Avoid a divide-by-zero error here
   {
     // Calculate the number of pixels to sample from by setting a bottom limit
     // for the contribution of the outermost pixel
     float minimumWeightToFindEdgeOfSamplingArea = 1.0 / 256.0;
     calculatedSampleRadius =
-        floor(sqrt(-2.0 * pow(sigma_, 2.0) *
+        floor(sqrt(-2.0 * pow(sigma, 2.0) *
                    log(minimumWeightToFindEdgeOfSamplingArea *
-                       sqrt(2.0 * M_PI * pow(sigma_, 2.0)))));
+                       sqrt(2.0 * M_PI * pow(sigma, 2.0)))));
     calculatedSampleRadius +=
         calculatedSampleRadius %
         2;  // There's nothing to gain from handling odd
             // radius sizes, due to the optimizations I use
   }
-  radius_ = calculatedSampleRadius;
-
-  if (filter_program_) {
-    delete filter_program_;
-    filter_program_ = 0;
-  }
-  InitWithShaderString(GenerateOptimizedVertexShaderString(radius_, sigma_),
-                       GenerateOptimizedFragmentShaderString(radius_, sigma_));
+  return calculatedSampleRadius;
 }
 
-bool GaussianBlurMonoFilter::DoRender(bool updateSinks) {
-  RotationMode inputRotation =
-      input_framebuffers_.begin()->second.rotation_mode;
-
-  if (rotationSwapsSize(inputRotation)) {
-    if (type_ == HORIZONTAL) {
-      filter_program_->SetUniformValue("texelWidthOffset", (float)0.0);
-      filter_program_->SetUniformValue(
-          "texelHeightOffset",
-          (float)(vertical_texel_spacing_ / framebuffer_->GetWidth()));
-    } else {
-      filter_program_->SetUniformValue(
-          "texelWidthOffset",
-          (float)(horizontal_texel_spacing_ / framebuffer_->GetHeight()));
-      filter_program_->SetUniformValue("texelHeightOffset", (float)0.0);
-    }
-  } else {
-    if (type_ == HORIZONTAL) {
-      filter_program_->SetUniformValue(
-          "texelWidthOffset",
-          (float)(horizontal_texel_spacing_ / framebuffer_->GetWidth()));
-      filter_program_->SetUniformValue("texelHeightOffset", (float)0.0);
-    } else {
-      filter_program_->SetUniformValue("texelWidthOffset", (float)0.0);
-      filter_program_->SetUniformValue(
-          "texelHeightOffset",
-          (float)(vertical_texel_spacing_ / framebuffer_->GetHeight()));
-    }
+void GaussianBlurMonoFilter::ApplyRadius(int radius) {
+  if (radius == radius_) {
+    return;
   }
-  return Filter::DoRender(updateSinks);
-}
 
-void GaussianBlurMonoFilter::SetTexelSpacingMultiplier(float value) {
-  vertical_texel_spacing_ = value;
-  horizontal_texel_spacing_ = value;
+  radius_ = radius;
+  UpdateBlurProgram();
 }
 
-std::string GaussianBlurMonoFilter::GenerateVertexShaderString(int radius,
-                                                               float sigma) {
-  if (radius < 1 || sigma <= 0.0) {
-    return kDefaultVertexShader;
+void GaussianBlurMonoFilter::ApplySigma(float sigma) {
+  if (sigma == sigma_) {
+    return;
   }
 
-  std::string shaderStr = Util::StringFormat(
-      "\
-        attribute vec4 position;\n\
-        attribute vec4 inputTextureCoordinate;\n\
-        uniform float texelWidthOffset;\n\
-        uniform float texelHeightOffset;\n\
-        varying vec2 blurCoordinates[%d];\n\
-        void main()\n\
-        {\n\
-            gl_Position = position;\n\
-            vec2 texelSpacing = vec2(texelWidthOffset, texelHeightOffset);\n\
-        ",
-      radius * 2 + 1);
+  // Sigma is no longer rounded, the weights are uniforms so fractional
+  // values cost nothing
+  sigma_ = sigma;
+  radius_ = RadiusForSigma(sigma_);
+  UpdateBlurProgram();
+}
 
-  for (int i = 0; i < radius * 2 + 1; ++i) {
-    int offsetFromCenter = i - radius;
-    if (offsetFromCenter == 0) {
-      shaderStr = shaderStr +
-                  Util::StringFormat(
-                      "blurCoordinates[%d] = inputTextureCoordinate.xy;\n", i);
-    } else {
-      shaderStr =
-          shaderStr + Util::StringFormat(
-                          "blurCoordinates[%d] = inputTextureCoordinate.xy + "
-                          "texelSpacing * (%f);\n",
-                          i, (float)offsetFromCenter);
-    }
+int GaussianBlurMonoFilter::PairCountForRadius(int radius) {
+  int pairs = (std::min(std::max(radius, 1), kMaxRadius) + 1) / 2;
+  int bucket = 2;
+  while (bucket < pairs) {
+    bucket *= 2;
   }
-
-  shaderStr += "}\n";
-
-  return shaderStr;
+  return bucket;
 }
 
-std::string GaussianBlurMonoFilter::GenerateFragmentShaderString(int radius,
-                                                                 float sigma) {
-  if (radius < 1 || sigma <= 0.0) {
-    return kDefaultFragmentShader;
+void GaussianBlurMonoFilter::UpdateBlurProgram() {
+  if (radius_ > kMaxRadius) {
+    LOG_WARN("GaussianBlurMonoFilter: radius {} clamped to {}", radius_,
+             kMaxRadius);
   }
-
-  float* standardGaussianWeights = new float[radius + 1];
-  float sumOfWeights = 0.0;
-  for (int i = 0; i < radius + 1; ++i) {
-    standardGaussianWeights[i] = (1.0 / sqrt(2.0 * M_PI * pow(sigma, 2.0))) *
-                                 exp(-pow(i, 2.0) / (2.0 * pow(sigma, 2.0)));
-
-    if (i == 0) {
-      sumOfWeights += standardGaussianWeights[i];
-    } else {
-      sumOfWeights += 2.0 * standardGaussianWeights[i];
+  int pair_count = PairCountForRadius(radius_);
+  UpdateBlurWeights(pair_count);
+
+  auto it = bucket_programs_.find(pair_count);
+  if (it == bucket_programs_.end()) {
+    std::shared_ptr<GPUPixelGLProgram> shared_program;
+    GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+      std::string vertex = GenerateOptimizedVertexShaderString(radius_, sigma_);
+      std::string fragment =
+          GenerateOptimizedFragmentShaderString(radius_, sigma_);
+      auto& programs = SharedPrograms();
+      std::string key = vertex + '\0' + fragment;
+      auto shared = programs.find(key);
+      if (shared != programs.end()) {
+        shared_program = shared->second.lock();
+      }
+      if (!shared_program) {
+        shared_program.reset(
+            GPUPixelGLProgram::CreateWithShaderString(vertex, fragment));
+        // Drop programs nobody holds any more before adding this one
+        for (auto entry = programs.begin(); entry != programs.end();) {
+          entry = entry->second.expired() ? programs.erase(entry)
+                                          : std::next(entry);
+        }
+        programs[key] = shared_program;
+      }
+    });
+    if (!shared_program) {
+      LOG_ERROR("GaussianBlurMonoFilter: failed to build blur program");
+      return;
     }
+    it = bucket_programs_.emplace(pair_count, shared_program).first;
   }
-  for (int i = 0; i < radius + 1; ++i) {
-    standardGaussianWeights[i] = standardGaussianWeights[i] / sumOfWeights;
-  }
-#if defined(GPUPIXEL_GLES_SHADER)
-  std::string shaderStr = Util::StringFormat(
-      "\
-           uniform sampler2D inputImageTexture;\n\
-           varying highp vec2 blurCoordinates[%d];\n\
-           void main()\n\
-           {\n\
-               gl_FragColor = vec4(0.0);\n",
-      radius * 2 + 1);
-#elif defined(GPUPIXEL_GL_SHADER)
-  std::string shaderStr = Util::StringFormat(
-      "\
-           uniform sampler2D inputImageTexture;\n\
-           varying vec2 blurCoordinates[%d];\n\
-           void main()\n\
-           {\n\
-               gl_FragColor = vec4(0.0);\n",
-      radius * 2 + 1);
-#endif
-  for (int i = 0; i < radius * 2 + 1; ++i) {
-    int offsetFromCenter = i - radius;
-    shaderStr += Util::StringFormat(
-        "gl_FragColor += texture2D(inputImageTexture, "
-        "blurCoordinates[%d]) * %f;\n",
-        i, standardGaussianWeights[abs(offsetFromCenter)]);
-  }
-  shaderStr += "}";
-
-  delete[] standardGaussianWeights;
-  standardGaussianWeights = 0;
+  GPUPixelGLProgram* program = it->second.get();
 
-  return shaderStr;
+  if (program == filter_program_) {
+    return;
+  }
+  filter_program_ = program;
+  GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    filter_position_attribute_ = filter_program_->GetAttribLocation("position");
+    GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
+    GL_CALL(glEnableVertexAttribArray(filter_position_attribute_));
+  });
 }
 
-std::string GaussianBlurMonoFilter::GenerateOptimizedVertexShaderString(
-    int radius,
-    float sigma) {
-  if (radius < 1 || sigma <= 0.0) {
-    return kDefaultVertexShader;
+void GaussianBlurMonoFilter::UpdateBlurWeights(int pair_count) {
+  int radius = std::min(radius_, kMaxRadius);
+  blur_taps_.assign(pair_count * 2, 0.0);
+  if (radius < 1 || sigma_ <= 0.0) {
+    center_weight_ = 1.0;
+    return;
   }
 
-  // 1. generate the normal Gaussian weights for a given sigma
-  float* standardGaussianWeights = new float[radius + 1];
+  // 1. generate the normal Gaussian weights for a given sigma, one spare
+  // entry so the last pair of an odd radius reads a zero weight
+  std::vector<float> standardGaussianWeights(radius + 2, 0.0);
   float sumOfWeights = 0.0;
   for (int i = 0; i < radius + 1; ++i) {
-    standardGaussianWeights[i] = (1.0 / sqrt(2.0 * M_PI * pow(sigma, 2.0))) *
-                                 exp(-pow(i, 2.0) / (2.0 * pow(sigma, 2.0)));
+    standardGaussianWeights[i] = (1.0 / sqrt(2.0 * M_PI * pow(sigma_, 2.0))) *
+                                 exp(-pow(i, 2.0) / (2.0 * pow(sigma_, 2.0)));
     if (i == 0) {
       sumOfWeights += standardGaussianWeights[i];
     } else {
@@ -241,182 +199,145 @@ std::string GaussianBlurMonoFilter::GenerateOptimizedVertexShaderString(
   for (int i = 0; i < radius + 1; ++i) {
     standardGaussianWeights[i] = standardGaussianWeights[i] / sumOfWeights;
   }
+  center_weight_ = standardGaussianWeights[0];
 
-  // 3. From these weights we calculate the offsets to read interpolated
-  // values from
-  int numberOfOptimizedOffsets = fmin(radius / 2 + (radius % 2), 7);
-  float* optimizedGaussianOffsets = new float[numberOfOptimizedOffsets];
-
+  // 3. merge neighbouring taps into one linear-filtered read each, unused
+  // pairs of the bucket keep a zero weight
+  int numberOfOptimizedOffsets = radius / 2 + (radius % 2);
   for (int i = 0; i < numberOfOptimizedOffsets; ++i) {
     float firstWeight = standardGaussianWeights[i * 2 + 1];
     float secondWeight = standardGaussianWeights[i * 2 + 2];
-
     float optimizedWeight = firstWeight + secondWeight;
+    // Tail weights underflow for small sigmas, the pair then stays unused
+    if (optimizedWeight <= 0.0) {
+      continue;
+    }
 
-    optimizedGaussianOffsets[i] =
+    blur_taps_[i * 2] =
         (firstWeight * (i * 2 + 1) + secondWeight * (i * 2 + 2)) /
         optimizedWeight;
+    blur_taps_[i * 2 + 1] = optimizedWeight;
   }
+}
 
-#if defined(GPUPIXEL_GLES_SHADER)
-  std::string shaderStr = Util::StringFormat(
-      "\
-               attribute vec4 position;\n\
-               attribute vec4 inputTextureCoordinate;\n\
-               uniform float texelWidthOffset;\n\
-               uniform float texelHeightOffset;\n\
-               varying highp vec2 blurCoordinates[%d];\n\
-               void main()\n\
-               {\n\
-               gl_Position = position;\n\
-               vec2 texelSpacing = vec2(texelWidthOffset, texelHeightOffset);\n\
-               ",
-      numberOfOptimizedOffsets * 2 + 1);
-#elif defined(GPUPIXEL_GL_SHADER)
-  std::string shaderStr = Util::StringFormat(
-      "\
-               attribute vec4 position;\n\
-               attribute vec4 inputTextureCoordinate;\n\
-               float texelWidthOffset;\n\
-               float texelHeightOffset;\n\
-               varying vec2 blurCoordinates[%d];\n\
-               void main()\n\
-               {\n\
-               gl_Position = position;\n\
-               vec2 texelSpacing = vec2(texelWidthOffset, texelHeightOffset);\n\
-               ",
-      numberOfOptimizedOffsets * 2 + 1);
-#endif
-  shaderStr =
-      shaderStr +
-      Util::StringFormat("blurCoordinates[0] = inputTextureCoordinate.xy;\n");
-  for (int i = 0; i < numberOfOptimizedOffsets; ++i) {
-    shaderStr =
-        shaderStr +
-        Util::StringFormat(
-            "blurCoordinates[%d] = inputTextureCoordinate.xy + texelSpacing * (%f);\n\
-            blurCoordinates[%d] = inputTextureCoordinate.xy - texelSpacing * (%f);",
-            i * 2 + 1, optimizedGaussianOffsets[i], i * 2 + 2,
-            optimizedGaussianOffsets[i]);
+bool GaussianBlurMonoFilter::DoRender(bool updateSinks) {
+  RotationMode inputRotation =
+      input_framebuffers_.begin()->second.rotation_mode;
+
+  if (rotationSwapsSize(inputRotation)) {
+    if (type_ == HORIZONTAL) {
+      filter_program_->SetUniformValue("texelWidthOffset", (float)0.0);
+      filter_program_->SetUniformValue(
+          "texelHeightOffset",
+          (float)(vertical_texel_spacing_ / framebuffer_->GetWidth()));
+    } else {
+      filter_program_->SetUniformValue(
+          "texelWidthOffset",
+          (float)(horizontal_texel_spacing_ / framebuffer_->GetHeight()));
+      filter_program_->SetUniformValue("texelHeightOffset", (float)0.0);
+    }
+  } else {
+    if (type_ == HORIZONTAL) {
+      filter_program_->SetUniformValue(
+          "texelWidthOffset",
+          (float)(horizontal_texel_spacing_ / framebuffer_->GetWidth()));
+      filter_program_->SetUniformValue("texelHeightOffset", (float)0.0);
+    } else {
+      filter_program_->SetUniformValue("texelWidthOffset", (float)0.0);
+      filter_program_->SetUniformValue(
+          "texelHeightOffset",
+          (float)(vertical_texel_spacing_ / framebuffer_->GetHeight()));
+    }
   }
+  if (!blur_taps_.empty()) {
+    filter_program_->SetUniformValue("centerWeight", center_weight_);
+    filter_program_->SetUniformArray("blurTaps", blur_taps_.data(), 4,
+                                     (int)blur_taps_.size() / 4);
+  }
+  return Filter::DoRender(updateSinks);
+}
 
-  shaderStr += "}\n";
+void GaussianBlurMonoFilter::SetTexelSpacingMultiplier(float value) {
+  vertical_texel_spacing_ = value;
+  horizontal_texel_spacing_ = value;
+}
 
-  delete[] standardGaussianWeights;
-  delete[] optimizedGaussianOffsets;
+std::string GaussianBlurMonoFilter::GetFingerprint() const {
+  return Util::StringFormat("%s:%d:%d:%f:%f:%f", typeid(*this).name(), type_,
+                            radius_, sigma_, horizontal_texel_spacing_,
+                            vertical_texel_spacing_);
+}
 
-  return shaderStr;
+std::string GaussianBlurMonoFilter::GenerateOptimizedVertexShaderString(
+    int /*radius*/,
+    float /*sigma*/) {
+  return kDefaultVertexShader;
 }
 
 std::string GaussianBlurMonoFilter::GenerateOptimizedFragmentShaderString(
     int radius,
-    float sigma) {
-  if (radius < 1 || sigma <= 0.0) {
-    return kDefaultFragmentShader;
-  }
-
-  // 1. generate the normal Gaussian weights for a given sigma
-  float* standardGaussianWeights = new float[radius + 1];
-  float sumOfWeights = 0.0;
-  for (int i = 0; i < radius + 1; ++i) {
-    standardGaussianWeights[i] = (1.0 / sqrt(2.0 * M_PI * pow(sigma, 2.0))) *
-                                 exp(-pow(i, 2.0) / (2.0 * pow(sigma, 2.0)));
-    if (i == 0) {
-      sumOfWeights += standardGaussianWeights[i];
-    } else {
-      sumOfWeights += 2.0 * standardGaussianWeights[i];
-    }
-  }
-
-  // 2. normalize these weights to prevent the clipping of the Gaussian curve
-  // at the end of the discrete samples from reducing luminance
-  for (int i = 0; i < radius + 1; ++i) {
-    standardGaussianWeights[i] = standardGaussianWeights[i] / sumOfWeights;
-  }
+    float /*sigma*/) {
+  return GenerateBucketFragmentShaderString(PairCountForRadius(radius), false);
+}
 
-  // 3. From these weights we calculate the offsets to read interpolated
-  // values from
-  int trueNumberOfOptimizedOffsets = radius / 2 + (radius % 2);
-  int numberOfOptimizedOffsets = fmin(trueNumberOfOptimizedOffsets, 7);
+std::string GaussianBlurMonoFilter::GenerateBucketFragmentShaderString(
+    int pair_count,
+    bool single_component) const {
+  // Offsets and weights are uniforms and the loop bound is a constant, so a
+  // single program serves every radius up to 2 * |pair_count| and any sigma
 #if defined(GPUPIXEL_GLES_SHADER)
   std::string shaderStr = Util::StringFormat(
       "\
                uniform sampler2D inputImageTexture;\n\
                uniform highp float texelWidthOffset;\n\
                uniform highp float texelHeightOffset;\n\
-               varying highp vec2 blurCoordinates[%d];\n\
+               uniform highp float centerWeight;\n\
+               uniform highp vec4 blurTaps[%d];\n\
+               varying highp vec2 textureCoordinate;\n\
                void main()\n\
                {\n\
-               gl_FragColor = vec4(0.0);\n",
-      numberOfOptimizedOffsets * 2 + 1);
+               highp vec2 texelSpacing = vec2(texelWidthOffset, texelHeightOffset);\n\
+               highp vec4 tap;\n",
+      pair_count / 2);
+  shaderStr += single_component ? "lowp float sum;\n" : "lowp vec4 sum;\n";
 #elif defined(GPUPIXEL_GL_SHADER)
   std::string shaderStr = Util::StringFormat(
       "\
                uniform sampler2D inputImageTexture;\n\
                uniform float texelWidthOffset;\n\
                uniform float texelHeightOffset;\n\
-               varying vec2 blurCoordinates[%d];\n\
+               uniform float centerWeight;\n\
+               uniform vec4 blurTaps[%d];\n\
+               varying vec2 textureCoordinate;\n\
                void main()\n\
                {\n\
-               gl_FragColor = vec4(0.0);\n",
-      numberOfOptimizedOffsets * 2 + 1);
+               vec2 texelSpacing = vec2(texelWidthOffset, texelHeightOffset);\n\
+               vec4 tap;\n",
+      pair_count / 2);
+  shaderStr += single_component ? "float sum;\n" : "vec4 sum;\n";
 #endif
+  const char* component = single_component ? ".r" : "";
   shaderStr += Util::StringFormat(
-      "gl_FragColor += texture2D(inputImageTexture, "
-      "blurCoordinates[0]) * %f;\n",
-      standardGaussianWeights[0]);
-  for (int i = 0; i < numberOfOptimizedOffsets; ++i) {
-    float firstWeight = standardGaussianWeights[i * 2 + 1];
-    float secondWeight = standardGaussianWeights[i * 2 + 2];
-    float optimizedWeight = firstWeight + secondWeight;
-
-    shaderStr += Util::StringFormat(
-        "gl_FragColor += texture2D(inputImageTexture, "
-        "blurCoordinates[%d]) * %f;\n",
-        i * 2 + 1, optimizedWeight);
-    shaderStr += Util::StringFormat(
-        "gl_FragColor += texture2D(inputImageTexture, "
-        "blurCoordinates[%d]) * %f;\n",
-        i * 2 + 2, optimizedWeight);
-  }
-
-  // If the number of required samples exceeds the amount we can pass in via
-  // varyings, we have to do dependent texture reads in the fragment shader
-  if (trueNumberOfOptimizedOffsets > numberOfOptimizedOffsets) {
-#if defined(GPUPIXEL_GLES_SHADER)
-    shaderStr += Util::StringFormat(
-        "highp vec2 texelSpacing = vec2(texelWidthOffset, "
-        "texelHeightOffset);\n");
-#elif defined(GPUPIXEL_GL_SHADER)
-    shaderStr += Util::StringFormat(
-        "vec2 texelSpacing = vec2(texelWidthOffset, texelHeightOffset);\n");
-#endif
-    for (int i = numberOfOptimizedOffsets; i < trueNumberOfOptimizedOffsets;
-         i++) {
-      float firstWeight = standardGaussianWeights[i * 2 + 1];
-      float secondWeight = standardGaussianWeights[i * 2 + 2];
-
-      float optimizedWeight = firstWeight + secondWeight;
-      float optimizedOffset =
-          (firstWeight * (i * 2 + 1) + secondWeight * (i * 2 + 2)) /
-          optimizedWeight;
-
-      shaderStr += Util::StringFormat(
-          "gl_FragColor += texture2D(inputImageTexture, "
-          "blurCoordinates[0] + texelSpacing * %f) * %f;\n",
-          optimizedOffset, optimizedWeight);
-
-      shaderStr += Util::StringFormat(
-          "gl_FragColor += texture2D(inputImageTexture, "
-          "blurCoordinates[0] - texelSpacing * %f) * %f;\n",
-          optimizedOffset, optimizedWeight);
-    }
-  }
-
+      "sum = texture2D(inputImageTexture, textureCoordinate)%s * "
+      "centerWeight;\n",
+      component);
+  shaderStr += Util::StringFormat("for (int i = 0; i < %d; i++) {\n",
+                                  pair_count / 2);
+  shaderStr += "tap = blurTaps[i];\n";
+  shaderStr += Util::StringFormat(
+      "sum += texture2D(inputImageTexture, textureCoordinate + texelSpacing * "
+      "tap.x)%s * tap.y;\n"
+      "sum += texture2D(inputImageTexture, textureCoordinate - texelSpacing * "
+      "tap.x)%s * tap.y;\n"
+      "sum += texture2D(inputImageTexture, textureCoordinate + texelSpacing * "
+      "tap.z)%s * tap.w;\n"
+      "sum += texture2D(inputImageTexture, textureCoordinate - texelSpacing * "
+      "tap.z)%s * tap.w;\n",
+      component, component, component, component);
+  shaderStr += "}\n";
+  shaderStr += single_component ? "gl_FragColor = vec4(sum, sum, sum, 1.0);\n"
+                                : "gl_FragColor = sum;\n";
   shaderStr += "}";
-
-  delete[] standardGaussianWeights;
-  standardGaussianWeights = 0;
   return shaderStr;
 }
 
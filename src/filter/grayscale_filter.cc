@@ -55,4 +55,8 @@ bool GrayscaleFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string GrayscaleFilter::GetFingerprint() const {
+  return "GrayscaleFilter";
+}
+
 }  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/hue_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 #include "gpupixel/utils/math_toolbox.h"
 namespace gpupixel {
 
@@ -88,4 +89,8 @@ bool HueFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string HueFilter::GetFingerprint() const {
+  return Util::StringFormat("HueFilter:%f", hue_adjustment_);
+}
+
 }  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/luminance_range_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 #if defined(GPUPIXEL_GLES_SHADER)
@@ -83,4 +84,8 @@ bool LuminanceRangeFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string LuminanceRangeFilter::GetFingerprint() const {
+  return Util::StringFormat("LuminanceRangeFilter:%f", range_reduction_factor_);
+}
+
 }  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/posterize_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 #if defined(GPUPIXEL_GLES_SHADER)
@@ -69,4 +70,8 @@ bool PosterizeFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string PosterizeFilter::GetFingerprint() const {
+  return Util::StringFormat("PosterizeFilter:%d", color_levels_);
+}
+
 }  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/rgb_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 const std::string kRGBFragmentShaderString = R"(
@@ -90,4 +91,9 @@ bool RGBFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string RGBFilter::GetFingerprint() const {
+  return Util::StringFormat("RGBFilter:%f:%f:%f", red_adjustment_,
+                            green_adjustment_, blue_adjustment_);
+}
+
 }  // namespace gpupixel
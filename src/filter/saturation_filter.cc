@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/saturation_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 const std::string kSaturationFragmentShaderString = R"(
@@ -64,4 +65,8 @@ bool SaturationFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string SaturationFilter::GetFingerprint() const {
+  return Util::StringFormat("SaturationFilter:%f", saturation_);
+}
+
 }  // namespace gpupixel
@@ -69,6 +69,7 @@ bool SketchFilter::Init() {
   }
 
   grayscale_filter_ = GrayscaleFilter::Create();
+  grayscale_filter_->SetOutputFormat(GPUPIXEL_FRAMEBUFFER_FORMAT_R8);
   sketch_filter_ = _SketchFilter::Create();
   grayscale_filter_->AddSink(sketch_filter_);
   AddFilter(grayscale_filter_);
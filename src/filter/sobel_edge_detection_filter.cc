@@ -73,6 +73,7 @@ bool SobelEdgeDetectionFilter::Init() {
   }
 
   grayscale_filter_ = GrayscaleFilter::Create();
+  grayscale_filter_->SetOutputFormat(GPUPIXEL_FRAMEBUFFER_FORMAT_R8);
   sobel_edge_detection_filter_ = _SobelEdgeDetectionFilter::Create();
   grayscale_filter_->AddSink(sobel_edge_detection_filter_);
   AddFilter(grayscale_filter_);
@@ -0,0 +1,149 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/filter/stencil_chain_filter.h"
+#include "core/gpupixel_context.h"
+#include "utils/util.h"
+
+namespace gpupixel {
+
+StencilChainFilter::StencilChainFilter() {}
+
+StencilChainFilter::~StencilChainFilter() {}
+
+std::shared_ptr<StencilChainFilter> StencilChainFilter::Create(
+    const std::vector<Stage>& stages,
+    const std::string& declarations /* = ""*/) {
+  auto ret = std::shared_ptr<StencilChainFilter>(new StencilChainFilter());
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (ret && !ret->Init(stages, declarations)) {
+      ret.reset();
+    }
+  });
+  return ret;
+}
+
+bool StencilChainFilter::Init(const std::vector<Stage>& stages,
+                              const std::string& declarations) {
+  if (stages.empty()) {
+    return false;
+  }
+  // The first stage reads the input image, only later ones need a halo
+  int halo_x = 0;
+  int halo_y = 0;
+  for (size_t i = 1; i < stages.size(); i++) {
+    halo_x += stages[i].radius_x;
+    halo_y += stages[i].radius_y;
+  }
+  if (halo_x > kMaxHalo || halo_y > kMaxHalo) {
+    LOG_WARN("StencilChainFilter: halo {}x{} exceeds {}", halo_x, halo_y,
+             kMaxHalo);
+    return false;
+  }
+
+  // Empty fragment source, nothing to fall back to
+  return InitWithComputeShaderString(
+      GenerateComputeShaderString(stages, declarations), "");
+}
+
+std::string StencilChainFilter::GenerateComputeShaderString(
+    const std::vector<Stage>& stages,
+    const std::string& declarations) {
+  int stage_count = (int)stages.size();
+
+  // remaining[i] is the halo stage i must still produce for the stages after
+  // it, the tile is sized for what the second stage reads
+  std::vector<int> remaining_x(stage_count, 0);
+  std::vector<int> remaining_y(stage_count, 0);
+  for (int i = stage_count - 2; i >= 0; i--) {
+    remaining_x[i] = remaining_x[i + 1] + stages[i + 1].radius_x;
+    remaining_y[i] = remaining_y[i + 1] + stages[i + 1].radius_y;
+  }
+  int halo_x = remaining_x[0];
+  int halo_y = remaining_y[0];
+
+  std::string shader = Util::StringFormat(
+      "#define HALO_X %d\n"
+      "#define HALO_Y %d\n"
+      "#define TILE_W (WORK_GROUP_SIZE + 2 * HALO_X)\n"
+      "#define TILE_H (WORK_GROUP_SIZE + 2 * HALO_Y)\n",
+      halo_x, halo_y);
+  shader += R"(
+    shared vec4 tile0[TILE_W * TILE_H];
+    shared vec4 tile1[TILE_W * TILE_H];
+    ivec2 outputSize;
+    ivec2 tileOrigin;
+
+    bool insideImage(ivec2 pixel) {
+      return all(greaterThanEqual(pixel, ivec2(0))) &&
+             all(lessThan(pixel, outputSize));
+    }
+
+    // Clamping keeps every read inside the region the previous stage wrote
+    vec4 readImage(ivec2 pixel) {
+      pixel = clamp(pixel, ivec2(0), outputSize - 1);
+      return texture(inputImageTexture, textureCoordinateAt(pixel));
+    }
+
+    vec4 readTile0(ivec2 pixel) {
+      ivec2 p = clamp(pixel, ivec2(0), outputSize - 1) - tileOrigin;
+      return tile0[p.y * TILE_W + p.x];
+    }
+
+    vec4 readTile1(ivec2 pixel) {
+      ivec2 p = clamp(pixel, ivec2(0), outputSize - 1) - tileOrigin;
+      return tile1[p.y * TILE_W + p.x];
+    }
+)";
+  shader += declarations + "\n";
+
+  for (int i = 0; i < stage_count; i++) {
+    shader += Util::StringFormat(
+        "vec4 stage%d(ivec2 pixel) {\n"
+        "#define sampleInput(offset) %s(pixel + (offset))\n",
+        i, i == 0 ? "readImage" : (i % 2 == 1 ? "readTile0" : "readTile1"));
+    shader += stages[i].source;
+    shader += "\n#undef sampleInput\n}\n";
+  }
+
+  shader +=
+      "void main() {\n"
+      "  outputSize = imageSize(outputImage);\n"
+      "  tileOrigin = ivec2(gl_WorkGroupID.xy) * WORK_GROUP_SIZE -\n"
+      "               ivec2(HALO_X, HALO_Y);\n";
+  // Every stage but the last fills its shrinking part of the tile, with the
+  // whole work group striding over it
+  for (int i = 0; i + 1 < stage_count; i++) {
+    int start_x = halo_x - remaining_x[i];
+    int start_y = halo_y - remaining_y[i];
+    int width = kWorkGroupSize + 2 * remaining_x[i];
+    int height = kWorkGroupSize + 2 * remaining_y[i];
+    shader += Util::StringFormat(
+        "  for (int i = int(gl_LocalInvocationIndex); i < %d;\n"
+        "       i += WORK_GROUP_SIZE * WORK_GROUP_SIZE) {\n"
+        "    ivec2 local = ivec2(%d + i %% %d, %d + i / %d);\n"
+        "    ivec2 pixel = tileOrigin + local;\n"
+        "    if (insideImage(pixel)) {\n"
+        "      tile%d[local.y * TILE_W + local.x] =\n"
+        "          clamp(stage%d(pixel), 0.0, 1.0);\n"
+        "    }\n"
+        "  }\n"
+        "  memoryBarrierShared();\n"
+        "  barrier();\n",
+        width * height, start_x, width, start_y, width, i % 2, i);
+  }
+  shader += Util::StringFormat(
+      "  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"
+      "  if (insideImage(pixel)) {\n"
+      "    imageStore(outputImage, pixel, stage%d(pixel));\n"
+      "  }\n"
+      "}\n",
+      stage_count - 1);
+  return shader;
+}
+
+}  // namespace gpupixel
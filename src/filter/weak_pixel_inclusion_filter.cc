@@ -102,6 +102,7 @@ std::shared_ptr<WeakPixelInclusionFilter> WeakPixelInclusionFilter::Create() {
 
 bool WeakPixelInclusionFilter::Init() {
   if (InitWithFragmentShaderString(kWeakPixelInclusionFragmentShaderString)) {
+    SetOutputFormat(GPUPIXEL_FRAMEBUFFER_FORMAT_R8);
     return true;
   }
   return false;
@@ -7,6 +7,7 @@
 
 #include "gpupixel/filter/white_balance_filter.h"
 #include "core/gpupixel_context.h"
+#include "utils/util.h"
 namespace gpupixel {
 
 const std::string kWhiteBalanceFragmentShaderString = R"(
@@ -87,4 +88,8 @@ bool WhiteBalanceFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+std::string WhiteBalanceFilter::GetFingerprint() const {
+  return Util::StringFormat("WhiteBalanceFilter:%f:%f", temperature_, tint_);
+}
+
 }  // namespace gpupixel
@@ -32,11 +32,19 @@ void Sink::SetInputFramebuffer(std::shared_ptr<GPUPixelFramebuffer> framebuffer,
   input_frame_buffer_info.tex_index = tex_idx;
   input_frame_buffer_info.ignore_for_prepare = false;
   input_framebuffers_[tex_idx] = input_frame_buffer_info;
+  ReserveInput(tex_idx);
+}
+
+void Sink::ReserveInput(int tex_idx) {
+  if (tex_idx >= 0 && tex_idx < 32) {
+    reserved_inputs_.fetch_or(1u << tex_idx, std::memory_order_relaxed);
+  }
 }
 
 int Sink::NextAvailableTextureIndex() const {
-  for (int i = 0; i < input_count_; ++i) {
-    if (input_framebuffers_.find(i) == input_framebuffers_.end()) {
+  uint32_t reserved = reserved_inputs_.load(std::memory_order_relaxed);
+  for (int i = 0; i < input_count_ && i < 32; ++i) {
+    if (!(reserved & (1u << i))) {
       return i;
     }
   }
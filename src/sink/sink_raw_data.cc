@@ -7,6 +7,7 @@
 //
 
 #include "gpupixel/sink/sink_raw_data.h"
+#include <algorithm>
 #include <cstring>
 #include "core/gpupixel_context.h"
 #include "libyuv.h"
@@ -52,19 +53,7 @@ SinkRawData::SinkRawData() {
                        kRGBToI420FragmentShaderString);
 }
 
-SinkRawData::~SinkRawData() {
-  // Clean up RGBA frame buffer
-  if (rgba_buffer_ != nullptr) {
-    delete[] rgba_buffer_;
-  }
-  rgba_buffer_ = nullptr;
-
-  // Clean up YUV frame buffer
-  if (yuv_buffer_ != nullptr) {
-    delete[] yuv_buffer_;
-  }
-  yuv_buffer_ = nullptr;
-}
+SinkRawData::~SinkRawData() {}
 
 void SinkRawData::Render() {
   if (input_framebuffers_.empty()) {
@@ -73,11 +62,20 @@ void SinkRawData::Render() {
 
   int width = input_framebuffers_[0].frame_buffer->GetWidth();
   int height = input_framebuffers_[0].frame_buffer->GetHeight();
+  if (GPUPixelContext::GetInstance()->IsPreparingFrame()) {
+    // The last frame stays readable, the framebuffer for this size goes
+    // straight to the factory's idle pool
+    if (width_ != width || height_ != height) {
+      GPUPixelContext::GetInstance()
+          ->GetFramebufferFactory()
+          ->CreateFramebuffer(width, height);
+    }
+    return;
+  }
   if (width_ != width || height_ != height) {
     width_ = width;
     height_ = height;
     InitFramebuffer(width, height);
-    InitOutputBuffer(width, height);
   }
 
   GPUPixelContext::GetInstance()->SetActiveGlProgram(shader_program_);
@@ -131,53 +129,264 @@ bool SinkRawData::InitWithShaderString(
   return true;
 }
 
-int SinkRawData::RenderToOutput() {
+int SinkRawData::RenderToOutput(uint8_t* buffer, int stride) {
   framebuffer_->Activate();
 
   // Read pixel data directly using glReadPixels
-  GL_CALL(glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
-                       rgba_buffer_));
+  if (stride == width_ * 4) {
+    GL_CALL(glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+                         buffer));
+#if !defined(GPUPIXEL_IOS)
+  } else if (stride % 4 == 0) {
+    GL_CALL(glPixelStorei(GL_PACK_ROW_LENGTH, stride / 4));
+    GL_CALL(glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+                         buffer));
+    GL_CALL(glPixelStorei(GL_PACK_ROW_LENGTH, 0));
+#endif
+  } else {
+    // The iOS ES 2.0 context has no GL_PACK_ROW_LENGTH
+    for (int y = 0; y < height_; ++y) {
+      GL_CALL(glReadPixels(0, y, width_, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                           buffer + y * stride));
+    }
+  }
 
   framebuffer_->Deactivate();
   return 0;
 }
 
 const uint8_t* SinkRawData::GetRgbaBuffer() {
-  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext(
-      [&] { RenderToOutput(); });
-  return rgba_buffer_;
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (width_ == 0) {
+      return;
+    }
+    rgba_buffer_.resize(width_ * height_ * 4);
+    RenderToOutput(rgba_buffer_.data(), width_ * 4);
+  });
+  return rgba_buffer_.empty() ? nullptr : rgba_buffer_.data();
 }
 
 const uint8_t* SinkRawData::GetI420Buffer() {
-  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext(
-      [=] { RenderToOutput(); });
+  bool ret = false;
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (width_ == 0) {
+      return;
+    }
+    int width = width_;
+    int height = height_;
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (height + 1) / 2;
+    yuv_buffer_.resize(width * height + chroma_width * chroma_height * 2);
+    uint8_t* data_y = yuv_buffer_.data();
+    uint8_t* data_u = data_y + width * height;
+    uint8_t* data_v = data_u + chroma_width * chroma_height;
+    ConvertToI420(data_y, width, data_u, chroma_width, data_v, chroma_width);
+    ret = true;
+  });
+  return ret ? yuv_buffer_.data() : nullptr;
+}
+
+bool SinkRawData::ReadRgba(uint8_t* buffer,
+                           int width,
+                           int height,
+                           int stride) {
+  bool ret = false;
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    // Checked here, Render() may resize between tasks
+    if (width_ == 0 || width_ != width || height_ != height) {
+      return;
+    }
+    RenderToOutput(buffer, stride ? stride : width * 4);
+    ret = true;
+  });
+  return ret;
+}
+
+bool SinkRawData::ReadI420(uint8_t* data_y,
+                           int stride_y,
+                           uint8_t* data_u,
+                           int stride_u,
+                           uint8_t* data_v,
+                           int stride_v,
+                           int width,
+                           int height) {
+  bool ret = false;
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (width_ == 0 || width_ != width || height_ != height) {
+      return;
+    }
+    ConvertToI420(data_y, stride_y, data_u, stride_u, data_v, stride_v);
+    ret = true;
+  });
+  return ret;
+}
+
+void SinkRawData::ConvertToI420(uint8_t* data_y,
+                                int stride_y,
+                                uint8_t* data_u,
+                                int stride_u,
+                                uint8_t* data_v,
+                                int stride_v) {
+  int width = width_;
+  int height = height_;
+  // Not rgba_buffer_, the caller of GetRgbaBuffer() may still read it
+  conversion_buffer_.resize(width * height * 4);
+  RenderToOutput(conversion_buffer_.data(), width * 4);
 
   // Convert RGBA to I420 format
-  libyuv::ARGBToI420(rgba_buffer_, width_ * 4, yuv_buffer_, width_,
-                     yuv_buffer_ + width_ * height_, width_ / 2,
-                     yuv_buffer_ + width_ * height_ * 5 / 4, width_ / 2, width_,
-                     height_);
+  libyuv::ARGBToI420(conversion_buffer_.data(), width * 4, data_y,
+                     stride_y ? stride_y : width, data_u,
+                     stride_u ? stride_u : (width + 1) / 2, data_v,
+                     stride_v ? stride_v : (width + 1) / 2, width, height);
+}
+
+// Free list of output buffers, shared with the handles so that frames can
+// be released after the sink is gone
+struct SinkRawData::FramePool {
+  struct Buffer {
+    uint8_t* data;
+    size_t size;
+    std::unique_ptr<uint8_t[]> storage;
+  };
+
+  Buffer* Acquire(size_t size) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto it = free_buffers.begin(); it != free_buffers.end(); ++it) {
+      if ((*it)->size >= size) {
+        Buffer* buffer = *it;
+        free_buffers.erase(it);
+        return buffer;
+      }
+    }
+    if (external) {
+      return nullptr;
+    }
+
+    // Own buffers that are too small won't fit any later frame either
+    for (auto it = free_buffers.begin(); it != free_buffers.end();) {
+      Buffer* buffer = *it;
+      it = free_buffers.erase(it);
+      buffers.erase(std::find_if(
+          buffers.begin(), buffers.end(),
+          [buffer](const std::unique_ptr<Buffer>& b) {
+            return b.get() == buffer;
+          }));
+    }
+    std::unique_ptr<Buffer> buffer(new Buffer());
+    buffer->storage.reset(new uint8_t[size]);
+    buffer->data = buffer->storage.get();
+    buffer->size = size;
+    buffers.push_back(std::move(buffer));
+    return buffers.back().get();
+  }
 
-  return yuv_buffer_;
+  void Release(Buffer* buffer) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (external && buffer->storage) {
+      // Own buffer handed out before the caller registered theirs
+      buffers.erase(std::find_if(
+          buffers.begin(), buffers.end(),
+          [buffer](const std::unique_ptr<Buffer>& b) {
+            return b.get() == buffer;
+          }));
+      return;
+    }
+    free_buffers.push_back(buffer);
+  }
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  std::vector<Buffer*> free_buffers;
+  // Registered by the caller, the pool never allocates then
+  bool external = false;
+};
+
+void SinkRawData::AddOutputBuffer(uint8_t* buffer, size_t size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!pool_) {
+    pool_ = std::make_shared<FramePool>();
+  }
+  std::unique_lock<std::mutex> pool_lock(pool_->mutex);
+  if (!pool_->external) {
+    // Own buffers still in use are freed with their handles
+    for (FramePool::Buffer* free_buffer : pool_->free_buffers) {
+      pool_->buffers.erase(std::find_if(
+          pool_->buffers.begin(), pool_->buffers.end(),
+          [free_buffer](const std::unique_ptr<FramePool::Buffer>& b) {
+            return b.get() == free_buffer;
+          }));
+    }
+    pool_->free_buffers.clear();
+    pool_->external = true;
+  }
+  std::unique_ptr<FramePool::Buffer> entry(new FramePool::Buffer());
+  entry->data = buffer;
+  entry->size = size;
+  pool_->free_buffers.push_back(entry.get());
+  pool_->buffers.push_back(std::move(entry));
 }
 
-void SinkRawData::InitOutputBuffer(int width, int height) {
-  uint32_t rgba_size = width * height * 4;
-  uint32_t yuv_size = width * height * 3 / 2;
+OutputFrameHandle SinkRawData::AcquireRgbaFrame() {
+  return AcquireFrame(GPUPIXEL_FRAME_TYPE_RGBA);
+}
+
+OutputFrameHandle SinkRawData::AcquireI420Frame() {
+  return AcquireFrame(GPUPIXEL_FRAME_TYPE_YUVI420);
+}
 
-  // Allocate RGBA frame buffer
-  if (rgba_buffer_ != nullptr) {
-    delete[] rgba_buffer_;
+OutputFrameHandle SinkRawData::AcquireFrame(GPUPIXEL_FRAME_TYPE type) {
+  std::shared_ptr<FramePool> pool;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!pool_) {
+      pool_ = std::make_shared<FramePool>();
+    }
+    pool = pool_;
   }
-  rgba_buffer_ = new uint8_t[rgba_size];
-  std::memset(rgba_buffer_, 0, rgba_size);
 
-  // Allocate YUV frame buffer
-  if (yuv_buffer_ != nullptr) {
-    delete[] yuv_buffer_;
+  OutputFrame* frame = nullptr;
+  FramePool::Buffer* buffer = nullptr;
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    // Sized in the task that reads, Render() can't resize in between
+    int width = width_;
+    int height = height_;
+    if (width == 0) {
+      return;
+    }
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (height + 1) / 2;
+    size_t size = type == GPUPIXEL_FRAME_TYPE_RGBA
+                      ? width * height * 4
+                      : width * height + chroma_width * chroma_height * 2;
+    buffer = pool->Acquire(size);
+    if (!buffer) {
+      LOG_WARN("SinkRawData: all {} output buffers are in use",
+               pool->buffers.size());
+      return;
+    }
+
+    if (type == GPUPIXEL_FRAME_TYPE_RGBA) {
+      RenderToOutput(buffer->data, width * 4);
+    } else {
+      uint8_t* data_u = buffer->data + width * height;
+      ConvertToI420(buffer->data, width, data_u, chroma_width,
+                    data_u + chroma_width * chroma_height, chroma_width);
+    }
+
+    frame = new OutputFrame();
+    frame->data = buffer->data;
+    frame->width = width;
+    frame->height = height;
+    frame->stride = type == GPUPIXEL_FRAME_TYPE_RGBA ? width * 4 : width;
+    frame->type = type;
+  });
+  if (!frame) {
+    return nullptr;
   }
-  yuv_buffer_ = new uint8_t[yuv_size];
-  std::memset(yuv_buffer_, 0, yuv_size);
+  return OutputFrameHandle(frame, [pool, buffer](const OutputFrame* frame) {
+    pool->Release(buffer);
+    delete frame;
+  });
 }
 
 void SinkRawData::InitFramebuffer(int width, int height) {
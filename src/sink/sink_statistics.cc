@@ -0,0 +1,378 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/sink/sink_statistics.h"
+#include <algorithm>
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_gl_compute.h"
+
+namespace gpupixel {
+
+namespace {
+const int kBinCount = 256;
+const int kHistogramCount = 4;
+const int kWorkGroupSize = 16;
+
+const std::string kStatisticsComputeShaderString = R"(#version 430
+    layout(local_size_x = 16, local_size_y = 16) in;
+    layout(std430, binding = 0) buffer Histograms { uint bins[1024]; };
+    uniform sampler2D inputImageTexture;
+    // Monochrome input counts towards all three channels
+    uniform bool singleChannel;
+
+    // Per work group bins keep global atomics to one per non-empty bin
+    shared uint localBins[1024];
+
+    void main() {
+      for (uint i = gl_LocalInvocationIndex; i < 1024u; i += 256u) {
+        localBins[i] = 0u;
+      }
+      memoryBarrierShared();
+      barrier();
+
+      ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+      if (all(lessThan(pixel, textureSize(inputImageTexture, 0)))) {
+        vec4 color = texelFetch(inputImageTexture, pixel, 0);
+        if (singleChannel) {
+          color.gb = color.rr;
+        }
+        float luminance = dot(color.rgb, vec3(0.2125, 0.7154, 0.0721));
+        uvec4 value = min(uvec4(vec4(luminance, color.rgb) * 255.0 + 0.5),
+                          uvec4(255u));
+        atomicAdd(localBins[value.x], 1u);
+        atomicAdd(localBins[256u + value.y], 1u);
+        atomicAdd(localBins[512u + value.z], 1u);
+        atomicAdd(localBins[768u + value.w], 1u);
+      }
+      memoryBarrierShared();
+      barrier();
+
+      for (uint i = gl_LocalInvocationIndex; i < 1024u; i += 256u) {
+        if (localBins[i] != 0u) {
+          atomicAdd(bins[i], localBins[i]);
+        }
+      }
+    })";
+
+const std::string kStatisticsSampleVertexShaderString = R"(
+    attribute vec4 position;
+    attribute vec4 inputTextureCoordinate;
+    varying vec2 textureCoordinate;
+
+    void main() {
+      gl_Position = position;
+      textureCoordinate = inputTextureCoordinate.xy;
+    })";
+
+#if defined(GPUPIXEL_GLES_SHADER)
+const std::string kStatisticsSampleFragmentShaderString = R"(
+    varying mediump vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform bool singleChannel;
+    void main() {
+      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
+      gl_FragColor = singleChannel ? color.rrra : color;
+    })";
+#elif defined(GPUPIXEL_GL_SHADER)
+const std::string kStatisticsSampleFragmentShaderString = R"(
+    varying vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+    uniform bool singleChannel;
+    void main() {
+      vec4 color = texture2D(inputImageTexture, textureCoordinate);
+      gl_FragColor = singleChannel ? color.rrra : color;
+    })";
+#endif
+
+// R8 framebuffers rely on a texture swizzle to read as luminance, which
+// desktop GL before 3.3 ignores
+bool IsSingleChannel(const GPUPixelFramebuffer& framebuffer) {
+#if defined(GPUPIXEL_GL_RG_FORMATS)
+  return framebuffer.GetTextureAttributes().format == GL_RED;
+#else
+  return false;
+#endif
+}
+
+float MeanOfHistogram(const uint32_t* histogram, uint32_t sample_count) {
+  uint64_t sum = 0;
+  for (int i = 0; i < kBinCount; i++) {
+    sum += (uint64_t)histogram[i] * i;
+  }
+  return sample_count ? sum / (255.0f * sample_count) : 0.0f;
+}
+}  // namespace
+
+float ImageStatistics::GetLuminancePercentile(float percentile) const {
+  uint64_t target =
+      (uint64_t)(std::min(std::max(percentile, 0.0f), 1.0f) * sample_count);
+  uint64_t count = 0;
+  for (int i = 0; i < kBinCount; i++) {
+    count += luminance_histogram[i];
+    if (count > target) {
+      return i / 255.0f;
+    }
+  }
+  return max_luminance;
+}
+
+SinkStatistics::SinkStatistics() {}
+
+SinkStatistics::~SinkStatistics() {
+  if (buffers_[0]) {
+    GPUPixelContext::GetInstance()->DeleteBuffer(buffers_[0]);
+    GPUPixelContext::GetInstance()->DeleteBuffer(buffers_[1]);
+  }
+  delete program_;
+}
+
+std::shared_ptr<SinkStatistics> SinkStatistics::Create() {
+  auto ret = std::shared_ptr<SinkStatistics>(new SinkStatistics());
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (ret && !ret->Init()) {
+      ret.reset();
+    }
+  });
+  return ret;
+}
+
+bool SinkStatistics::Init() {
+#if defined(GPUPIXEL_GL_COMPUTE)
+  if (GetGLComputeFunctions()) {
+    program_ = GPUPixelGLProgram::CreateWithComputeShaderString(
+        kStatisticsComputeShaderString);
+  }
+  if (program_) {
+    using_compute_ = true;
+    GL_CALL(glGenBuffers(2, buffers_));
+    for (auto buffer : buffers_) {
+      GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer));
+      GL_CALL(glBufferData(GL_SHADER_STORAGE_BUFFER,
+                           kBinCount * kHistogramCount * sizeof(uint32_t),
+                           nullptr, GL_DYNAMIC_READ));
+    }
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+    return true;
+  }
+#endif
+
+  program_ = GPUPixelGLProgram::CreateWithShaderString(
+      kStatisticsSampleVertexShaderString,
+      kStatisticsSampleFragmentShaderString);
+  if (!program_) {
+    return false;
+  }
+  position_attribute_ = program_->GetAttribLocation("position");
+  tex_coord_attribute_ = program_->GetAttribLocation("inputTextureCoordinate");
+  sample_framebuffer_ = GPUPixelContext::GetInstance()
+                            ->GetFramebufferFactory()
+                            ->CreateFramebuffer(kSampleGridSize,
+                                                kSampleGridSize);
+  samples_.resize(kSampleGridSize * kSampleGridSize * 4);
+  bins_.resize(kBinCount * kHistogramCount);
+
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  // An ES 2.0 context reads the grid synchronously
+  if (!GPUPixelContext::GetInstance()->HasPixelBuffers()) {
+    return true;
+  }
+  GL_CALL(glGenBuffers(2, buffers_));
+  for (auto buffer : buffers_) {
+    GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer));
+    GL_CALL(glBufferData(GL_PIXEL_PACK_BUFFER, samples_.size(), nullptr,
+                         GL_STREAM_READ));
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+#endif
+  return true;
+}
+
+void SinkStatistics::SetCallback(StatisticsCallback callback) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  callback_ = callback;
+}
+
+ImageStatistics SinkStatistics::GetStatistics() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return statistics_;
+}
+
+void SinkStatistics::Render() {
+  if (input_framebuffers_.empty()) {
+    return;
+  }
+  if (using_compute_) {
+    RenderWithCompute();
+  } else {
+    RenderWithSampling();
+  }
+}
+
+void SinkStatistics::RenderWithCompute() {
+#if defined(GPUPIXEL_GL_COMPUTE)
+  static const uint32_t kZeroBins[kBinCount * kHistogramCount] = {};
+  const GLComputeFunctions* compute = GetGLComputeFunctions();
+  auto input = input_framebuffers_.begin()->second.frame_buffer;
+
+  GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers_[current_]));
+  GL_CALL(glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(kZeroBins),
+                          kZeroBins));
+  GL_CALL(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffers_[current_]));
+
+  GPUPixelContext::GetInstance()->SetActiveGlProgram(program_);
+  GL_CALL(glActiveTexture(GL_TEXTURE0));
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, input->GetTexture()));
+  program_->SetUniformValue("inputImageTexture", 0);
+  program_->SetUniformValue("singleChannel", IsSingleChannel(*input) ? 1 : 0);
+  GL_CALL(compute->dispatch_compute(
+      (input->GetWidth() + kWorkGroupSize - 1) / kWorkGroupSize,
+      (input->GetHeight() + kWorkGroupSize - 1) / kWorkGroupSize, 1));
+  GL_CALL(compute->memory_barrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+  pending_[current_] = true;
+  sample_count_[current_] = input->GetWidth() * input->GetHeight();
+
+  // The previous frame's dispatch has most likely finished by now
+  current_ = 1 - current_;
+  if (pending_[current_]) {
+    pending_[current_] = false;
+    GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers_[current_]));
+    const uint32_t* histograms = (const uint32_t*)glMapBufferRange(
+        GL_SHADER_STORAGE_BUFFER, 0, sizeof(kZeroBins), GL_MAP_READ_BIT);
+    if (histograms) {
+      Deliver(histograms, sample_count_[current_]);
+      GL_CALL(glUnmapBuffer(GL_SHADER_STORAGE_BUFFER));
+    }
+  }
+  GL_CALL(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+#endif
+}
+
+void SinkStatistics::RenderWithSampling() {
+  auto input = input_framebuffers_.begin()->second.frame_buffer;
+
+  GPUPixelContext::GetInstance()->SetActiveGlProgram(program_);
+  sample_framebuffer_->Activate();
+  GL_CALL(glViewport(0, 0, kSampleGridSize, kSampleGridSize));
+
+  float image_vertices[] = {
+      -1.0, -1.0,  // Bottom left
+      1.0,  -1.0,  // Bottom right
+      -1.0, 1.0,   // Top left
+      1.0,  1.0    // Top right
+  };
+  float texture_vertices[] = {
+      0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+  };
+  GL_CALL(glEnableVertexAttribArray(position_attribute_));
+  GL_CALL(glVertexAttribPointer(position_attribute_, 2, GL_FLOAT, 0, 0,
+                                image_vertices));
+  GL_CALL(glEnableVertexAttribArray(tex_coord_attribute_));
+  GL_CALL(glVertexAttribPointer(tex_coord_attribute_, 2, GL_FLOAT, 0, 0,
+                                texture_vertices));
+
+  GL_CALL(glActiveTexture(GL_TEXTURE0));
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, input->GetTexture()));
+  program_->SetUniformValue("inputImageTexture", 0);
+  program_->SetUniformValue("singleChannel", IsSingleChannel(*input) ? 1 : 0);
+  GL_CALL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  if (buffers_[0]) {
+    ReadSamplesAsync();
+    return;
+  }
+#endif
+  GL_CALL(glReadPixels(0, 0, kSampleGridSize, kSampleGridSize, GL_RGBA,
+                       GL_UNSIGNED_BYTE, samples_.data()));
+  sample_framebuffer_->Deactivate();
+  BinSamples(samples_.data());
+}
+
+void SinkStatistics::ReadSamplesAsync() {
+#if defined(GPUPIXEL_GL_PIXEL_BUFFERS)
+  // Queue this frame's read, then collect the one queued last frame
+  GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers_[current_]));
+  GL_CALL(glReadPixels(0, 0, kSampleGridSize, kSampleGridSize, GL_RGBA,
+                       GL_UNSIGNED_BYTE, 0));
+  pending_[current_] = true;
+  sample_framebuffer_->Deactivate();
+
+  current_ = 1 - current_;
+  if (pending_[current_]) {
+    pending_[current_] = false;
+    GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers_[current_]));
+    const uint8_t* rgba = (const uint8_t*)glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, samples_.size(), GL_MAP_READ_BIT);
+    if (rgba) {
+      BinSamples(rgba);
+      GL_CALL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+    }
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+#endif
+}
+
+void SinkStatistics::BinSamples(const uint8_t* rgba) {
+  std::fill(bins_.begin(), bins_.end(), 0);
+  int sample_count = kSampleGridSize * kSampleGridSize;
+  for (int i = 0; i < sample_count; i++, rgba += 4) {
+    int luminance = (int)(0.2125f * rgba[0] + 0.7154f * rgba[1] +
+                          0.0721f * rgba[2] + 0.5f);
+    bins_[std::min(luminance, kBinCount - 1)]++;
+    bins_[kBinCount + rgba[0]]++;
+    bins_[kBinCount * 2 + rgba[1]]++;
+    bins_[kBinCount * 3 + rgba[2]]++;
+  }
+  Deliver(bins_.data(), sample_count);
+}
+
+void SinkStatistics::Deliver(const uint32_t* histograms,
+                             uint32_t sample_count) {
+  ImageStatistics statistics;
+  std::copy(histograms, histograms + kBinCount,
+            statistics.luminance_histogram.begin());
+  std::copy(histograms + kBinCount, histograms + kBinCount * 2,
+            statistics.red_histogram.begin());
+  std::copy(histograms + kBinCount * 2, histograms + kBinCount * 3,
+            statistics.green_histogram.begin());
+  std::copy(histograms + kBinCount * 3, histograms + kBinCount * 4,
+            statistics.blue_histogram.begin());
+  statistics.sample_count = sample_count;
+
+  const uint32_t* luminance = statistics.luminance_histogram.data();
+  statistics.mean_luminance = MeanOfHistogram(luminance, sample_count);
+  statistics.mean_red =
+      MeanOfHistogram(statistics.red_histogram.data(), sample_count);
+  statistics.mean_green =
+      MeanOfHistogram(statistics.green_histogram.data(), sample_count);
+  statistics.mean_blue =
+      MeanOfHistogram(statistics.blue_histogram.data(), sample_count);
+  for (int i = 0; i < kBinCount; i++) {
+    if (luminance[i]) {
+      statistics.min_luminance = i / 255.0f;
+      break;
+    }
+  }
+  for (int i = kBinCount - 1; i >= 0; i--) {
+    if (luminance[i]) {
+      statistics.max_luminance = i / 255.0f;
+      break;
+    }
+  }
+
+  StatisticsCallback callback;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    statistics_ = statistics;
+    callback = callback_;
+  }
+  if (callback) {
+    callback(statistics);
+  }
+}
+
+}  // namespace gpupixel
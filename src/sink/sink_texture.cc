@@ -0,0 +1,87 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/sink/sink_texture.h"
+#include "core/gpupixel_context.h"
+
+namespace gpupixel {
+
+std::shared_ptr<SinkTexture> SinkTexture::Create() {
+  return std::shared_ptr<SinkTexture>(new SinkTexture());
+}
+
+SinkTexture::SinkTexture() {}
+
+SinkTexture::~SinkTexture() {
+  GPUPixelContext::GetInstance()->SyncRunWithContext([=] {
+    fence_.reset();
+    framebuffer_.reset();
+  });
+}
+
+void SinkTexture::Render() {
+  if (input_framebuffers_.empty()) {
+    return;
+  }
+
+  Fence fence;
+#if defined(GPUPIXEL_GL_SYNC_OBJECTS)
+  GLsync sync = GPUPixelContext::GetInstance()->HasSyncObjects()
+                    ? glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)
+                    : nullptr;
+  if (sync) {
+    // Consumers may hold it past the next frame, the last one deletes it
+    fence = Fence(sync, [](void* handle) {
+      GPUPixelContext::GetInstance()->DeleteSync(handle);
+    });
+  }
+#endif
+  // Other contexts only see the commands once they are submitted
+  GL_CALL(glFlush());
+
+  FrameCallback callback;
+  std::shared_ptr<GPUPixelFramebuffer> framebuffer =
+      input_framebuffers_[0].frame_buffer;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    fence_ = fence;
+    framebuffer_ = framebuffer;
+    callback = callback_;
+  }
+
+  if (callback) {
+    callback(framebuffer->GetTexture(), framebuffer->GetWidth(),
+             framebuffer->GetHeight(), fence);
+  }
+}
+
+void SinkTexture::SetFrameCallback(FrameCallback callback) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  callback_ = callback;
+}
+
+uint32_t SinkTexture::GetTexture() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return framebuffer_ ? framebuffer_->GetTexture() : 0;
+}
+
+int SinkTexture::GetWidth() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return framebuffer_ ? framebuffer_->GetWidth() : 0;
+}
+
+int SinkTexture::GetHeight() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return framebuffer_ ? framebuffer_->GetHeight() : 0;
+}
+
+SinkTexture::Fence SinkTexture::GetFence() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return fence_;
+}
+
+}  // namespace gpupixel
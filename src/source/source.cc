@@ -7,17 +7,30 @@
 
 #include "gpupixel/source/source.h"
 #include "core/gpupixel_context.h"
+#include "core/gpupixel_graph_snapshot.h"
 #include "utils/util.h"
 
 namespace gpupixel {
 
+GraphEdit::GraphEdit() {
+  GraphSnapshot::BeginEdit();
+}
+
+GraphEdit::~GraphEdit() {
+  GraphSnapshot::EndEdit();
+}
+
 Source::Source()
     : framebuffer_(0),
       output_rotation_(RotationMode::NoRotation),
       framebuffer_scale_(1.0) {}
 
 Source::~Source() {
-  RemoveAllSinks();
+  const Source* self = this;
+  if (!GraphSnapshot::Current()->GetSinks(self)->empty()) {
+    GraphSnapshot::Edit(
+        [self](GraphSnapshot& graph) { graph.SetSinks(self, nullptr); });
+  }
 }
 
 std::shared_ptr<Source> Source::AddSink(std::shared_ptr<Sink> sink) {
@@ -28,29 +41,49 @@ std::shared_ptr<Source> Source::AddSink(std::shared_ptr<Sink> sink) {
 std::shared_ptr<Source> Source::AddSink(std::shared_ptr<Sink> sink,
                                         int texIdx) {
   if (!HasSink(sink)) {
-    sinks_[sink] = texIdx;
-    sink->SetInputFramebuffer(framebuffer_, RotationMode::NoRotation, texIdx);
+    const Source* self = this;
+    GraphSnapshot::Edit([self, sink, texIdx](GraphSnapshot& graph) {
+      auto sinks =
+          std::make_shared<GraphSnapshot::SinkMap>(*graph.GetSinks(self));
+      (*sinks)[sink] = texIdx;
+      graph.SetSinks(self, sinks);
+    });
+    sink->ReserveInput(texIdx);
+    // Elsewhere the sink gets its input with the next frame
+    if (GPUPixelContext::GetInstance()->IsContextThread()) {
+      sink->SetInputFramebuffer(framebuffer_, RotationMode::NoRotation,
+                                texIdx);
+    }
   }
   return std::dynamic_pointer_cast<Source>(sink);
 }
 
 bool Source::HasSink(const std::shared_ptr<Sink> sink) const {
-  if (sinks_.find(sink) != sinks_.end()) {
-    return true;
-  } else {
-    return false;
-  }
+  auto sinks = GraphSnapshot::Current()->GetSinks(this);
+  return sinks->find(sink) != sinks->end();
+}
+
+std::shared_ptr<const Source::SinkMap> Source::GetSinks() const {
+  return GraphSnapshot::Current()->GetSinks(this);
 }
 
 void Source::RemoveSink(std::shared_ptr<Sink> sink) {
-  auto itr = sinks_.find(sink);
-  if (itr != sinks_.end()) {
-    sinks_.erase(itr);
-  }
+  const Source* self = this;
+  GraphSnapshot::Edit([self, sink](GraphSnapshot& graph) {
+    auto sinks = graph.GetSinks(self);
+    if (sinks->find(sink) == sinks->end()) {
+      return;
+    }
+    auto next = std::make_shared<GraphSnapshot::SinkMap>(*sinks);
+    next->erase(sink);
+    graph.SetSinks(self, next);
+  });
 }
 
 void Source::RemoveAllSinks() {
-  sinks_.clear();
+  const Source* self = this;
+  GraphSnapshot::Edit(
+      [self](GraphSnapshot& graph) { graph.SetSinks(self, nullptr); });
 }
 
 bool Source::DoRender(bool updateSinks) {
@@ -61,9 +94,16 @@ bool Source::DoRender(bool updateSinks) {
 }
 
 void Source::DoUpdateSinks() {
-  for (auto& it : sinks_) {
+  // Held for the loop, an edit on this thread may replace the snapshot
+  GraphSnapshot::FrameScope frame;
+  bool preparing = GPUPixelContext::GetInstance()->IsPreparingFrame();
+  auto sinks = GraphSnapshot::Current()->GetSinks(this);
+  for (auto& it : *sinks) {
     auto sink = it.first;
-    sink->SetInputFramebuffer(framebuffer_, output_rotation_, sinks_[sink]);
+    if (preparing && !sink->RendersPrepareFrames()) {
+      continue;
+    }
+    sink->SetInputFramebuffer(framebuffer_, output_rotation_, it.second);
     if (sink->IsReady()) {
       sink->Render();
       sink->ResetAndClean();
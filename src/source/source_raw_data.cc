@@ -6,7 +6,12 @@
  */
 
 #include "gpupixel/source/source_raw_data.h"
+#include <algorithm>
+#include <vector>
 #include "core/gpupixel_context.h"
+#include "core/gpupixel_graph_snapshot.h"
+#include "core/gpupixel_texture_uploader.h"
+#include "gpupixel/sink/sink_render.h"
 #include "utils/util.h"
 
 namespace gpupixel {
@@ -21,55 +26,129 @@ const std::string kI420VertexShaderString = R"(
       gl_Position = position;
     })";
 
+// texture_type: 0 I420, 1 RGBA, 2 NV12, 3 NV21, 4 YUY2, 5 UYVY, 6 BGRA
+// uploaded as RGBA. Packed YUV holds two pixels per texel, which is sampled
+// at its centre.
 #if defined(GPUPIXEL_GLES_SHADER)
 const std::string kI420FragmentShaderString = R"(
-    varying mediump vec2 textureCoordinate; uniform sampler2D yTexture;
+    varying mediump vec2 textureCoordinate;
+    uniform sampler2D yTexture;
     uniform sampler2D uTexture;
     uniform sampler2D vTexture;
+    uniform sampler2D uvTexture;
     uniform sampler2D inputImageTexture;
     uniform int texture_type;
-    mediump mat3 trans =
-        mat3(1.0, 1.0, 1.0,
-             0, -0.34414, 1.772,
-             1.402, -0.71414, 0);
+    uniform mediump mat3 colorConversion;
+    uniform mediump float lumaOffset;
+    uniform mediump float chromaInAlpha;
+    uniform highp float packedWidth;
 
     void main() {
-      mediump vec3 yuv;
-      if (texture_type == 0) {  // yuv
-        yuv.x = texture2D(yTexture, textureCoordinate).r;
-        yuv.y = texture2D(uTexture, textureCoordinate).r - 0.5;
-        yuv.z = texture2D(vTexture, textureCoordinate).r - 0.5;
+      if (texture_type == 1 || texture_type == 6) {
+        mediump vec4 color = texture2D(inputImageTexture, textureCoordinate);
+        gl_FragColor = texture_type == 1 ? color : color.bgra;
+        return;
+      }
 
-        gl_FragColor = vec4(trans * yuv, 1.0);
+      mediump vec3 yuv;
+      if (texture_type == 0) {
+        yuv = vec3(texture2D(yTexture, textureCoordinate).r,
+                   texture2D(uTexture, textureCoordinate).r,
+                   texture2D(vTexture, textureCoordinate).r);
+      } else if (texture_type == 2 || texture_type == 3) {
+        mediump vec4 chroma = texture2D(uvTexture, textureCoordinate);
+        mediump vec2 uv = mix(chroma.rg, chroma.ra, chromaInAlpha);
+        yuv = vec3(texture2D(yTexture, textureCoordinate).r,
+                   texture_type == 2 ? uv : uv.yx);
       } else {
-        gl_FragColor = texture2D(inputImageTexture, textureCoordinate);
+        highp float x = floor(textureCoordinate.x * packedWidth * 2.0);
+        highp float pair = floor(x * 0.5);
+        mediump vec4 texel = texture2D(
+            inputImageTexture,
+            vec2((pair + 0.5) / packedWidth, textureCoordinate.y));
+        bool odd = x - pair * 2.0 > 0.5;
+        if (texture_type == 4) {
+          yuv = vec3(odd ? texel.b : texel.r, texel.g, texel.a);
+        } else {
+          yuv = vec3(odd ? texel.a : texel.g, texel.r, texel.b);
+        }
       }
+      gl_FragColor = vec4(
+          colorConversion * (yuv - vec3(lumaOffset, 0.5, 0.5)), 1.0);
     })";
 #elif defined(GPUPIXEL_GL_SHADER)
 const std::string kI420FragmentShaderString = R"(
-    varying vec2 textureCoordinate; uniform sampler2D yTexture;
+    varying vec2 textureCoordinate;
+    uniform sampler2D yTexture;
     uniform sampler2D uTexture;
     uniform sampler2D vTexture;
+    uniform sampler2D uvTexture;
     uniform sampler2D inputImageTexture;
     uniform int texture_type;
-    mat3 trans = mat3(1.0, 1.0, 1.0,
-                      0, -0.34414, 1.772,
-                      1.402, -0.71414, 0);
+    uniform mat3 colorConversion;
+    uniform float lumaOffset;
+    uniform float chromaInAlpha;
+    uniform float packedWidth;
 
     void main() {
-      vec3 yuv;
-      if (texture_type == 0) {  // i420
-        yuv.x = texture2D(yTexture, textureCoordinate).r;
-        yuv.y = texture2D(uTexture, textureCoordinate).r - 0.5;
-        yuv.z = texture2D(vTexture, textureCoordinate).r - 0.5;
+      if (texture_type == 1 || texture_type == 6) {
+        vec4 color = texture2D(inputImageTexture, textureCoordinate);
+        gl_FragColor = texture_type == 1 ? color : color.bgra;
+        return;
+      }
 
-        gl_FragColor = vec4(trans * yuv, 1.0);
+      vec3 yuv;
+      if (texture_type == 0) {
+        yuv = vec3(texture2D(yTexture, textureCoordinate).r,
+                   texture2D(uTexture, textureCoordinate).r,
+                   texture2D(vTexture, textureCoordinate).r);
+      } else if (texture_type == 2 || texture_type == 3) {
+        vec4 chroma = texture2D(uvTexture, textureCoordinate);
+        vec2 uv = mix(chroma.rg, chroma.ra, chromaInAlpha);
+        yuv = vec3(texture2D(yTexture, textureCoordinate).r,
+                   texture_type == 2 ? uv : uv.yx);
       } else {
-        gl_FragColor = texture2D(inputImageTexture, textureCoordinate);
+        float x = floor(textureCoordinate.x * packedWidth * 2.0);
+        float pair = floor(x * 0.5);
+        vec4 texel = texture2D(
+            inputImageTexture,
+            vec2((pair + 0.5) / packedWidth, textureCoordinate.y));
+        bool odd = x - pair * 2.0 > 0.5;
+        if (texture_type == 4) {
+          yuv = vec3(odd ? texel.b : texel.r, texel.g, texel.a);
+        } else {
+          yuv = vec3(odd ? texel.a : texel.g, texel.r, texel.b);
+        }
       }
+      gl_FragColor = vec4(
+          colorConversion * (yuv - vec3(lumaOffset, 0.5, 0.5)), 1.0);
     })";
 #endif
 
+namespace {
+// YUV to RGB for the given colour space, limited range scales luma from
+// [16, 235] and chroma from [16, 240]
+void GetYuvConversion(GPUPIXEL_COLOR_SPACE color_space,
+                      Matrix3* matrix,
+                      float* luma_offset) {
+  bool bt709 = color_space == GPUPIXEL_COLOR_SPACE_BT709_FULL ||
+               color_space == GPUPIXEL_COLOR_SPACE_BT709_LIMITED;
+  bool limited = color_space == GPUPIXEL_COLOR_SPACE_BT601_LIMITED ||
+                 color_space == GPUPIXEL_COLOR_SPACE_BT709_LIMITED;
+  float kr = bt709 ? 0.2126f : 0.299f;
+  float kb = bt709 ? 0.0722f : 0.114f;
+  float kg = 1.0f - kr - kb;
+  float ys = limited ? 255.0f / 219.0f : 1.0f;
+  float cs = limited ? 255.0f / 224.0f : 1.0f;
+
+  matrix->set(ys, 0.0f, 2.0f * (1.0f - kr) * cs,  // r
+              ys, -2.0f * kb * (1.0f - kb) / kg * cs,
+              -2.0f * kr * (1.0f - kr) / kg * cs,  // g
+              ys, 2.0f * (1.0f - kb) * cs, 0.0f);  // b
+  *luma_offset = limited ? 16.0f / 255.0f : 0.0f;
+}
+}  // namespace
+
 std::shared_ptr<SourceRawData> SourceRawData::Create() {
   auto ret = std::shared_ptr<SourceRawData>(new SourceRawData());
   gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
@@ -82,10 +161,7 @@ std::shared_ptr<SourceRawData> SourceRawData::Create() {
 
 SourceRawData::SourceRawData() {}
 
-SourceRawData::~SourceRawData() {
-  GPUPixelContext::GetInstance()->SyncRunWithContext(
-      [=] { glDeleteTextures(4, textures_); });
-}
+SourceRawData::~SourceRawData() {}
 
 bool SourceRawData::Init() {
   filter_program_ = GPUPixelGLProgram::CreateWithShaderString(
@@ -97,17 +173,18 @@ bool SourceRawData::Init() {
   filter_tex_coord_attribute_ =
       filter_program_->GetAttribLocation("inputTextureCoordinate");
 
-  if (0 == textures_[0]) {
-    glGenTextures(4, textures_);
-  }
+  // Planes are uploaded to units 0, 1 and 2 in order, whatever the format
+  filter_program_->SetUniformValue("yTexture", 0);
+  filter_program_->SetUniformValue("uTexture", 1);
+  filter_program_->SetUniformValue("vTexture", 2);
+  filter_program_->SetUniformValue("uvTexture", 1);
+  filter_program_->SetUniformValue("inputImageTexture", 0);
 
-  for (int i = 0; i < 4; ++i) {
-    glBindTexture(GL_TEXTURE_2D, textures_[i]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  for (auto& uploader : plane_uploaders_) {
+    uploader.reset(new GPUPixelTextureUploader(1));
   }
+  uv_uploader_.reset(new GPUPixelTextureUploader(2));
+  rgba_uploader_.reset(new GPUPixelTextureUploader(4));
 
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
@@ -118,120 +195,235 @@ void SourceRawData::SetRotation(RotationMode rotation) {
   rotation_ = rotation;
 }
 
+void SourceRawData::SetColorSpace(GPUPIXEL_COLOR_SPACE color_space) {
+  color_space_ = color_space;
+}
+
+SourceRawData::Frame SourceRawData::ContiguousFrame(
+    const uint8_t* data,
+    int width,
+    int height,
+    int stride,
+    GPUPIXEL_FRAME_TYPE type) const {
+  // The texture used to be sized from the stride, never read past a row
+  if ((type == GPUPIXEL_FRAME_TYPE_RGBA || type == GPUPIXEL_FRAME_TYPE_BGRA) &&
+      stride > 0 && width * 4 > stride) {
+    width = stride / 4;
+  }
+
+  Frame frame;
+  frame.type = type;
+  frame.width = width;
+  frame.height = height;
+  frame.rotation = rotation_;
+  frame.planes[0] = data;
+  frame.strides[0] = stride;
+
+  // Chroma follows the luma plane, I420 with V right behind U
+  if (type == GPUPIXEL_FRAME_TYPE_YUVI420) {
+    int stride_y = stride ? stride : width;
+    frame.strides[1] = frame.strides[2] = stride_y / 2;
+    frame.planes[1] = data + stride_y * height;
+    frame.planes[2] = frame.planes[1] + (stride_y / 2) * ((height + 1) / 2);
+  } else if (type == GPUPIXEL_FRAME_TYPE_NV12 ||
+             type == GPUPIXEL_FRAME_TYPE_NV21) {
+    int stride_y = stride ? stride : width;
+    frame.strides[1] = stride_y;
+    frame.planes[1] = data + stride_y * height;
+  }
+  return frame;
+}
+
 void SourceRawData::ProcessData(const uint8_t* data,
                                 int width,
                                 int height,
                                 int stride,
                                 GPUPIXEL_FRAME_TYPE type) {
-  GPUPixelContext::GetInstance()->SyncRunWithContext([=] {
-    if (type == GPUPIXEL_FRAME_TYPE_YUVI420) {
-      // Calculate the starting pointers and strides for each YUV channel
-      const uint8_t* dataY = data;  // Y channel start position
-      int strideY = width;          // Y channel stride equals width
-
-      // U channel follows right after Y channel, size is width*height/4
-      const uint8_t* dataU = data + (width * height);
-      int strideU = width / 2;  // U channel stride is half the width
-
-      // V channel follows right after U channel, size is width*height/4
-      const uint8_t* dataV = dataU + (width * height / 4);
-      int strideV = width / 2;  // V channel stride is half the width
+  SubmitFrame(ContiguousFrame(data, width, height, stride, type), false);
+}
 
-      GenerateTextureWithI420(width, height, dataY, strideY, dataU, strideU,
-                              dataV, strideV);
+void SourceRawData::Prepare(int width, int height, GPUPIXEL_FRAME_TYPE type) {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  // Enough for every layout, the content is never shown
+  std::vector<uint8_t> blank((size_t)width * height * 4);
+  SubmitFrame(ContiguousFrame(blank.data(), width, height, 0, type), true);
+}
 
-    } else {
-      GenerateTextureWithPixels(data, width, height, stride, type);
-    }
-  });
+void SourceRawData::ProcessFrame(const Frame& frame) {
+  SubmitFrame(frame, false);
 }
 
-int SourceRawData::GenerateTextureWithI420(int width,
-                                           int height,
-                                           const uint8_t* dataY,
-                                           int strideY,
-                                           const uint8_t* dataU,
-                                           int strideU,
-                                           const uint8_t* dataV,
-                                           int strideV) {
-  if (!framebuffer_ || (framebuffer_->GetWidth() != width ||
-                        framebuffer_->GetHeight() != height)) {
-    framebuffer_ = GPUPixelContext::GetInstance()
-                       ->GetFramebufferFactory()
-                       ->CreateFramebuffer(width, height);
+void SourceRawData::SubmitFrame(const Frame& frame, bool prepare) {
+  GPUPIXEL_FRAME_TYPE type = frame.type;
+  bool i420 = type == GPUPIXEL_FRAME_TYPE_YUVI420;
+  bool semi_planar =
+      type == GPUPIXEL_FRAME_TYPE_NV12 || type == GPUPIXEL_FRAME_TYPE_NV21;
+  bool packed =
+      type == GPUPIXEL_FRAME_TYPE_YUY2 || type == GPUPIXEL_FRAME_TYPE_UYVY;
+  bool rgba =
+      type == GPUPIXEL_FRAME_TYPE_RGBA || type == GPUPIXEL_FRAME_TYPE_BGRA;
+  if (!i420 && !semi_planar && !packed && !rgba) {
+    LOG_ERROR("SourceRawData: unsupported frame type {}", (int)type);
+    return;
   }
 
-  this->SetFramebuffer(framebuffer_, NoRotation);
-
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
-  this->GetFramebuffer()->Activate();
+  // Crop, to whole chroma samples for subsampled formats
+  int x = std::max(0, std::min(frame.crop_x, frame.width));
+  int y = std::max(0, std::min(frame.crop_y, frame.height));
+  int width = frame.crop_width > 0 ? frame.crop_width : frame.width;
+  int height = frame.crop_height > 0 ? frame.crop_height : frame.height;
+  width = std::min(width, frame.width - x);
+  height = std::min(height, frame.height - y);
+  if (!rgba) {
+    x &= ~1;
+    width &= ~1;
+  }
+  if (i420 || semi_planar) {
+    y &= ~1;
+    height &= ~1;
+  }
+  if (width <= 0 || height <= 0 || !frame.planes[0]) {
+    LOG_ERROR("SourceRawData: empty frame {}x{}", width, height);
+    return;
+  }
 
-  float imageVertices[]{
-      -1.0, -1.0,  // left down
-      1.0,  -1.0,  // right down
-      -1.0, 1.0,   // left up
-      1.0,  1.0    // right up
+  int plane_count = 0;
+  UploadPlane planes[3];
+  auto add_plane = [&](GPUPixelTextureUploader* uploader, int index,
+                       int default_stride, int x_offset, int y_offset,
+                       int plane_width, int plane_height) {
+    int plane_stride =
+        frame.strides[index] ? frame.strides[index] : default_stride;
+    planes[plane_count++] = {
+        uploader, frame.planes[index] + y_offset * plane_stride + x_offset,
+        plane_width, plane_height, plane_stride};
   };
 
-  GL_CALL(glEnableVertexAttribArray(filter_position_attribute_));
-  GL_CALL(glVertexAttribPointer(filter_position_attribute_, 2, GL_FLOAT, 0, 0,
-                                imageVertices));
+  int texture_type = 1;
+  GLenum format = 0;
+  if (i420) {
+    add_plane(plane_uploaders_[0].get(), 0, frame.width, x, y, width, height);
+    add_plane(plane_uploaders_[1].get(), 1, frame.width / 2, x / 2, y / 2,
+              width / 2, height / 2);
+    add_plane(plane_uploaders_[2].get(), 2, frame.width / 2, x / 2, y / 2,
+              width / 2, height / 2);
+    texture_type = 0;
+  } else if (semi_planar) {
+    add_plane(plane_uploaders_[0].get(), 0, frame.width, x, y, width, height);
+    add_plane(uv_uploader_.get(), 1, frame.width, x, y / 2, width / 2,
+              height / 2);
+    texture_type = type == GPUPIXEL_FRAME_TYPE_NV12 ? 2 : 3;
+  } else if (packed) {
+    // Each texel holds a pixel pair
+    add_plane(rgba_uploader_.get(), 0, frame.width * 2, x * 2, y, width / 2,
+              height);
+    texture_type = type == GPUPIXEL_FRAME_TYPE_YUY2 ? 4 : 5;
+  } else {
+    add_plane(rgba_uploader_.get(), 0, frame.width * 4, x * 4, y, width,
+              height);
+    if (type == GPUPIXEL_FRAME_TYPE_BGRA) {
+      // Other platforms have no BGRA uploads, the shader swaps the channels
+#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
+      format = GL_BGRA;
+#else
+      texture_type = 6;
+#endif
+    }
+  }
 
-  GL_CALL(glEnableVertexAttribArray(filter_tex_coord_attribute_));
-  GL_CALL(glVertexAttribPointer(filter_tex_coord_attribute_, 2, GL_FLOAT, 0, 0,
-                                GetTextureCoordinate(rotation_)));
+  for (int i = 0; i < plane_count; ++i) {
+    if (!planes[i].data) {
+      LOG_ERROR("SourceRawData: plane {} of frame type {} is missing", i,
+                (int)type);
+      return;
+    }
+  }
 
-  filter_program_->SetUniformValue("yTexture", 0);
-  filter_program_->SetUniformValue("uTexture", 1);
-  filter_program_->SetUniformValue("vTexture", 2);
+  // Copy into the mapped upload buffers before handing over to the GL
+  // thread, whatever couldn't be staged is copied there
+  for (int i = 0; i < plane_count && !prepare; ++i) {
+    planes[i].uploader->Stage(planes[i].data, planes[i].width,
+                              planes[i].height, planes[i].stride);
+  }
 
-  const uint8_t* pixels[3] = {dataY, dataU, dataV};
-  const int widths[3] = {width, width / 2, width / 2};
-  const int heights[3] = {height, height / 2, height / 2};
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->SyncRunWithContext([&] {
+    // The rotation check and the dispatch see the same sinks
+    GraphSnapshot::FrameScope graph_frame;
+    context->SetPreparingFrame(prepare);
+    RenderPlanes(planes, plane_count, format, width, height, texture_type,
+                 frame.rotation);
+    context->SetPreparingFrame(false);
+  });
+}
 
-  for (int i = 0; i < 3; ++i) {
-    glActiveTexture(GL_TEXTURE0 + i);
-    glBindTexture(GL_TEXTURE_2D, textures_[i]);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, widths[i], heights[i], 0,
-                 GL_LUMINANCE, GL_UNSIGNED_BYTE, pixels[i]);
+bool SourceRawData::CanSinksRotate(RotationMode rotation) {
+  if (rotation == NoRotation) {
+    return true;
+  }
+  // SinkRawData and SinkTexture hand out their input as it is
+  auto sinks = GraphSnapshot::Current()->GetSinks(this);
+  for (auto& it : *sinks) {
+    if (!dynamic_cast<Filter*>(it.first.get()) &&
+        !dynamic_cast<SinkRender*>(it.first.get())) {
+      return false;
+    }
   }
+  return true;
+}
 
-  filter_program_->SetUniformValue("texture_type", 0);
-  // draw frame buffer
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-  this->GetFramebuffer()->Deactivate();
+void SourceRawData::RenderPlanes(const UploadPlane* planes,
+                                 int plane_count,
+                                 uint32_t format,
+                                 int width,
+                                 int height,
+                                 int texture_type,
+                                 RotationMode rotation) {
+  bool preparing = GPUPixelContext::GetInstance()->IsPreparingFrame();
+  for (int i = 0; i < plane_count; ++i) {
+    GL_CALL(glActiveTexture(GL_TEXTURE0 + i));
+    // A running stream keeps its textures, whatever size they are
+    if (preparing && planes[i].uploader->GetTexture()) {
+      GL_CALL(glBindTexture(GL_TEXTURE_2D, planes[i].uploader->GetTexture()));
+      continue;
+    }
+    planes[i].uploader->Upload(planes[i].data, planes[i].width,
+                               planes[i].height, planes[i].stride, format);
+  }
 
-  Source::DoRender(true);
-  return 0;
-}
+  // RGBA needs no conversion, the uploaded texture goes to the sinks as it
+  // is and the first consumer applies the rotation while sampling it
+  if (texture_type == 1 && CanSinksRotate(rotation)) {
+    GLuint texture = planes[0].uploader->GetTexture();
+    if (!upload_framebuffer_ || upload_framebuffer_->GetTexture() != texture ||
+        upload_framebuffer_->GetWidth() != width ||
+        upload_framebuffer_->GetHeight() != height) {
+      upload_framebuffer_ = GPUPixelContext::GetInstance()
+                                ->GetFramebufferFactory()
+                                ->CreateFramebufferWithTexture(texture, width,
+                                                               height);
+    }
+    this->SetFramebuffer(upload_framebuffer_, rotation);
+    Source::DoRender(true);
+    return;
+  }
 
-int SourceRawData::GenerateTextureWithPixels(const uint8_t* pixels,
-                                             int width,
-                                             int height,
-                                             int stride,
-                                             GPUPIXEL_FRAME_TYPE type) {
-  if (!framebuffer_ || (framebuffer_->GetWidth() != stride / 4 ||
-                        framebuffer_->GetHeight() != height)) {
+  // Rotated while converting, sized as the fast path's consumers size it
+  int output_width = width;
+  int output_height = height;
+  if (rotationSwapsSize(rotation)) {
+    std::swap(output_width, output_height);
+  }
+  if (!framebuffer_ || (framebuffer_->GetWidth() != output_width ||
+                        framebuffer_->GetHeight() != output_height)) {
     framebuffer_ = GPUPixelContext::GetInstance()
                        ->GetFramebufferFactory()
-                       ->CreateFramebuffer(stride / 4, height);
+                       ->CreateFramebuffer(output_width, output_height);
   }
   this->SetFramebuffer(framebuffer_, NoRotation);
 
-  uint32_t texture = textures_[3];
-
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture));
-
-  if (type == GPUPIXEL_FRAME_TYPE_BGRA) {
-#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
-    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, stride / 4, height, 0,
-                         GL_BGRA, GL_UNSIGNED_BYTE, pixels));
-#endif
-  } else if (type == GPUPIXEL_FRAME_TYPE_RGBA) {
-    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, stride / 4, height, 0,
-                         GL_RGBA, GL_UNSIGNED_BYTE, pixels));
-  }
-
   GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
   this->GetFramebuffer()->Activate();
 
@@ -239,26 +431,29 @@ int SourceRawData::GenerateTextureWithPixels(const uint8_t* pixels,
       -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
   };
 
-  filter_program_->SetUniformValue("texture_type", 1);
-
   GL_CALL(glEnableVertexAttribArray(filter_position_attribute_));
   GL_CALL(glVertexAttribPointer(filter_position_attribute_, 2, GL_FLOAT, 0, 0,
                                 imageVertices));
 
   GL_CALL(glEnableVertexAttribArray(filter_tex_coord_attribute_));
   GL_CALL(glVertexAttribPointer(filter_tex_coord_attribute_, 2, GL_FLOAT, 0, 0,
-                                GetTextureCoordinate(rotation_)));
-
-  GL_CALL(glActiveTexture(GL_TEXTURE4));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture));
-  filter_program_->SetUniformValue("inputImageTexture", 4);
+                                GetTextureCoordinate(rotation)));
+
+  Matrix3 conversion;
+  float luma_offset;
+  GetYuvConversion(color_space_, &conversion, &luma_offset);
+  filter_program_->SetUniformValue("colorConversion", conversion);
+  filter_program_->SetUniformValue("lumaOffset", luma_offset);
+  filter_program_->SetUniformValue(
+      "chromaInAlpha", uv_uploader_->IsSecondChannelInAlpha() ? 1.0f : 0.0f);
+  filter_program_->SetUniformValue("packedWidth", (float)planes[0].width);
+  filter_program_->SetUniformValue("texture_type", texture_type);
 
   // draw frame buffer
   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
   this->GetFramebuffer()->Deactivate();
 
   Source::DoRender(true);
-  return 0;
 }
 
 }  // namespace gpupixel
@@ -0,0 +1,148 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/source/source_texture.h"
+#include <cstring>
+#include "core/gpupixel_context.h"
+#include "utils/util.h"
+
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
+namespace gpupixel {
+
+#if defined(GPUPIXEL_ANDROID)
+const std::string kExternalTextureVertexShaderString = R"(
+    attribute vec4 position;
+    attribute vec4 inputTextureCoordinate;
+    uniform mat4 textureTransform;
+    varying vec2 textureCoordinate;
+
+    void main() {
+      gl_Position = position;
+      textureCoordinate = (textureTransform * inputTextureCoordinate).xy;
+    })";
+
+const std::string kExternalTextureFragmentShaderString = R"(
+    #extension GL_OES_EGL_image_external : require
+    precision mediump float;
+    varying highp vec2 textureCoordinate;
+    uniform samplerExternalOES inputImageTexture;
+
+    void main() {
+      gl_FragColor = texture2D(inputImageTexture, textureCoordinate);
+    })";
+#endif
+
+std::shared_ptr<SourceTexture> SourceTexture::Create() {
+  return std::shared_ptr<SourceTexture>(new SourceTexture());
+}
+
+SourceTexture::SourceTexture() {}
+
+SourceTexture::~SourceTexture() {
+  delete external_program_;
+}
+
+void SourceTexture::SetRotation(RotationMode rotation) {
+  rotation_ = rotation;
+}
+
+void SourceTexture::SetExternalTextureTransform(const float* matrix) {
+  std::memcpy(external_transform_, matrix, sizeof(external_transform_));
+}
+
+void SourceTexture::ProcessTexture(uint32_t texture,
+                                   int width,
+                                   int height,
+                                   TextureTarget target) {
+  GPUPixelContext::GetInstance()->SyncRunWithContext([=] {
+    if (target == kTextureExternalOES) {
+      RenderExternal(texture, width, height);
+      return;
+    }
+
+    if (!wrapped_framebuffer_ ||
+        wrapped_framebuffer_->GetTexture() != texture ||
+        wrapped_framebuffer_->GetWidth() != width ||
+        wrapped_framebuffer_->GetHeight() != height) {
+      wrapped_framebuffer_ = GPUPixelContext::GetInstance()
+                                 ->GetFramebufferFactory()
+                                 ->CreateFramebufferWithTexture(texture, width,
+                                                                height);
+    }
+    SetFramebuffer(wrapped_framebuffer_, rotation_);
+    Source::DoRender(true);
+    // Don't keep the caller's texture referenced between frames
+    SetFramebuffer(nullptr, rotation_);
+  });
+}
+
+bool SourceTexture::InitExternalProgram() {
+#if defined(GPUPIXEL_ANDROID)
+  external_program_ = GPUPixelGLProgram::CreateWithShaderString(
+      kExternalTextureVertexShaderString,
+      kExternalTextureFragmentShaderString);
+  if (!external_program_) {
+    return false;
+  }
+  external_position_attribute_ =
+      external_program_->GetAttribLocation("position");
+  external_tex_coord_attribute_ =
+      external_program_->GetAttribLocation("inputTextureCoordinate");
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SourceTexture::RenderExternal(uint32_t texture, int width, int height) {
+  if (!external_program_ && !InitExternalProgram()) {
+    LOG_ERROR("SourceTexture: external OES textures are not supported here");
+    return;
+  }
+
+  if (!external_framebuffer_ || external_framebuffer_->GetWidth() != width ||
+      external_framebuffer_->GetHeight() != height) {
+    external_framebuffer_ = GPUPixelContext::GetInstance()
+                                ->GetFramebufferFactory()
+                                ->CreateFramebuffer(width, height);
+  }
+
+  static const float image_vertices[] = {
+      -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
+  };
+  // Homogeneous, the transform may translate
+  static const float texture_vertices[] = {
+      0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+      0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+  };
+
+  GPUPixelContext::GetInstance()->SetActiveGlProgram(external_program_);
+  external_framebuffer_->Activate();
+  GL_CALL(glEnableVertexAttribArray(external_position_attribute_));
+  GL_CALL(glVertexAttribPointer(external_position_attribute_, 2, GL_FLOAT, 0,
+                                0, image_vertices));
+  GL_CALL(glEnableVertexAttribArray(external_tex_coord_attribute_));
+  GL_CALL(glVertexAttribPointer(external_tex_coord_attribute_, 4, GL_FLOAT, 0,
+                                0, texture_vertices));
+
+  GL_CALL(glActiveTexture(GL_TEXTURE0));
+  GL_CALL(glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture));
+  external_program_->SetUniformValue("inputImageTexture", 0);
+  external_program_->SetUniformValue("textureTransform",
+                                     Matrix4(external_transform_));
+  GL_CALL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+  GL_CALL(glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0));
+  external_framebuffer_->Deactivate();
+
+  SetFramebuffer(external_framebuffer_, rotation_);
+  Source::DoRender(true);
+}
+
+}  // namespace gpupixel
@@ -40,6 +40,14 @@ bool DispatchQueue::isWorkerThread() const {
   return std::this_thread::get_id() == workerId;
 }
 
+void DispatchQueue::postTask(std::function<void()> task) {
+  {
+    std::unique_lock<std::mutex> lk(m);
+    taskQueue.push(task);
+  }
+  cv.notify_one();
+}
+
 void DispatchQueue::runTask(std::function<void()> task) {
   // If current thread is the worker thread, execute the task directly to avoid
   // deadlock
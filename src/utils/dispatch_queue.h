@@ -41,6 +41,12 @@ class DispatchQueue {
    */
   void runTask(std::function<void()> task);
 
+  /**
+   * Queue a task without waiting for it
+   * @param task The function to execute
+   */
+  void postTask(std::function<void()> task);
+
   /**
    * Stop the worker thread
    */
@@ -0,0 +1,215 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "utils/logging.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifndef GPUPIXEL_EXTERNAL_CODE
+namespace gpupixel {
+
+namespace {
+constexpr int kMessagesPerSecond = 5;
+constexpr size_t kQueueSize = 1024;
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+const char* LevelTag(LogLevel level) {
+  switch (level) {
+    case LogLevel::Trace:
+      return "[GPUPixel][ TRACE ] ";
+    case LogLevel::Debug:
+      return "[GPUPixel][ DEBUG ] ";
+    case LogLevel::Info:
+      return "[GPUPixel][ INFO  ] ";
+    case LogLevel::Warn:
+      return "[GPUPixel][ WARN  ] ";
+    case LogLevel::Error:
+      return "[GPUPixel][ERROR  ] ";
+    case LogLevel::Critical:
+      return "[GPUPixel][ CRIT ] ";
+  }
+  return "[GPUPixel] ";
+}
+
+// Bounded queue for any number of writers and one reader. A writer claims a
+// slot by advancing the tail, each slot's sequence number tells whether it
+// is free for the writer of that position or filled for the reader.
+class LineQueue {
+ public:
+  LineQueue() {
+    for (size_t i = 0; i < kQueueSize; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // False when full
+  bool Push(std::string& line) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots_[pos % kQueueSize];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    Slot& slot = slots_[pos % kQueueSize];
+    slot.line.swap(line);
+    slot.sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Reader side
+  bool Pop(std::string& line) {
+    if (!HasLine()) {
+      return false;
+    }
+    Slot& slot = slots_[head_ % kQueueSize];
+    line.swap(slot.line);
+    slot.line.clear();
+    slot.sequence.store(head_ + kQueueSize, std::memory_order_release);
+    head_++;
+    return true;
+  }
+
+  bool HasLine() const {
+    return slots_[head_ % kQueueSize].sequence.load(
+               std::memory_order_acquire) == head_ + 1;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    std::string line;
+  };
+
+  Slot slots_[kQueueSize];
+  std::atomic<size_t> tail_{0};
+  size_t head_ = 0;
+};
+
+// Writes the queued lines to stdout on its own thread, so that logging
+// never waits on the console
+class Logger {
+ public:
+  // Leaked, static destructors may still log
+  static Logger& GetInstance() {
+    static Logger* logger = new Logger();
+    return *logger;
+  }
+
+  void Write(std::string& line) {
+#if defined(GPUPIXEL_WASM)
+    // No threads to hand it to
+    std::cout << line << std::endl;
+#else
+    if (!queue_.Push(line)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    if (sleeping_.exchange(false, std::memory_order_acq_rel)) {
+      wake_.notify_one();
+    }
+#endif
+  }
+
+  // Reader side, on the logging thread and at exit
+  bool Drain() {
+    std::unique_lock<std::mutex> lock(drain_mutex_);
+    bool wrote = false;
+    std::string line;
+    while (queue_.Pop(line)) {
+      std::cout << line << '\n';
+      wrote = true;
+    }
+    int dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+      std::cout << LevelTag(LogLevel::Warn) << dropped
+                << " log line(s) dropped, the queue was full\n";
+      wrote = true;
+    }
+    if (wrote) {
+      std::cout.flush();
+    }
+    return wrote;
+  }
+
+ private:
+  Logger() {
+#if !defined(GPUPIXEL_WASM)
+    std::thread([this] { Run(); }).detach();
+    std::atexit([] { Logger::GetInstance().Drain(); });
+#endif
+  }
+
+  void Run() {
+    for (;;) {
+      if (Drain()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      sleeping_.store(true, std::memory_order_release);
+      // Writers notify without the lock, a line queued right before the
+      // wait is picked up by the timeout
+      if (!queue_.HasLine()) {
+        wake_.wait_for(lock, std::chrono::milliseconds(100));
+      }
+      sleeping_.store(false, std::memory_order_release);
+    }
+  }
+
+  LineQueue queue_;
+  std::atomic<int> dropped_{0};
+  std::atomic<bool> sleeping_{false};
+  std::mutex drain_mutex_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+};
+}  // namespace
+
+bool LogSite::Allow(int& suppressed) {
+  int64_t now = NowMs();
+  int64_t start = window_start_ms_.load(std::memory_order_relaxed);
+  if (now - start >= 1000 &&
+      window_start_ms_.compare_exchange_strong(start, now,
+                                               std::memory_order_relaxed)) {
+    count_.store(0, std::memory_order_relaxed);
+  }
+  if (count_.fetch_add(1, std::memory_order_relaxed) >= kMessagesPerSecond) {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+  return true;
+}
+
+void LogMessage(LogLevel level, std::string message, int suppressed) {
+  std::string line = LevelTag(level) + message;
+  if (suppressed > 0) {
+    line += " (" + std::to_string(suppressed) + " similar suppressed)";
+  }
+  Logger::GetInstance().Write(line);
+}
+
+}  // namespace gpupixel
+#endif
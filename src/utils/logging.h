@@ -4,48 +4,143 @@
 #ifdef GPUPIXEL_EXTERNAL_CODE
 #include "base/logging.h"
 #else
-#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <sstream>
+#include <string>
+#include "utils/log_common.h"
 #endif
 
 #ifndef GPUPIXEL_EXTERNAL_CODE
+namespace gpupixel {
+namespace internal {
+
+// Writes |fmt| up to its next placeholder, then the argument. "{}" takes it
+// as is, "{:.Nf}" with N decimals. Without a placeholder left the argument
+// is appended after a space.
+template <typename T>
+void FormatNext(std::ostringstream& oss,
+                const std::string& fmt,
+                size_t& pos,
+                const T& arg) {
+  size_t open = fmt.find('{', pos);
+  size_t close = open == std::string::npos ? open : fmt.find('}', open);
+  if (close == std::string::npos) {
+    oss << fmt.substr(pos) << ' ' << arg;
+    pos = fmt.size();
+    return;
+  }
+  oss << fmt.substr(pos, open - pos);
+  std::string spec = fmt.substr(open + 1, close - open - 1);
+  if (spec.size() > 3 && spec.compare(0, 2, ":.") == 0 && spec.back() == 'f') {
+    std::ostringstream number;
+    number.setf(std::ios::fixed);
+    number.precision(std::atoi(spec.c_str() + 2));
+    number << arg;
+    oss << number.str();
+  } else {
+    oss << arg;
+  }
+  pos = close + 1;
+}
+
+}  // namespace internal
+}  // namespace gpupixel
+
+// Substitutes the arguments into the "{}" placeholders in turn
 template <typename... Args>
-std::string gpupixel_format(const std::string& fmt, Args... args) {
+std::string gpupixel_format(const std::string& fmt, const Args&... args) {
   std::ostringstream oss;
-  size_t index = 0;
-  ((oss << (index++ > 0 ? " " : "") << args), ...);
-  return fmt.substr(0, fmt.find("{}")) + oss.str() +
-         fmt.substr(fmt.find("{}") + 2);
+  size_t pos = 0;
+  (gpupixel::internal::FormatNext(oss, fmt, pos, args), ...);
+  if (pos < fmt.size()) {
+    oss << fmt.substr(pos);
+  }
+  return oss.str();
 }
 
+// Lowest level compiled in, calls below it vanish along with their
+// arguments: 0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 critical
+#ifndef GPUPIXEL_LOG_LEVEL
+#if defined(NDEBUG)
+#define GPUPIXEL_LOG_LEVEL 2
+#else
+#define GPUPIXEL_LOG_LEVEL 1
+#endif
+#endif
+
+namespace gpupixel {
+
+// Allows a call site a few messages per second, so that one logging every
+// frame can't flood the log
+class LogSite {
+ public:
+  // |suppressed| receives how many messages were dropped since the last
+  // one allowed
+  bool Allow(int& suppressed);
+
+ private:
+  std::atomic<int64_t> window_start_ms_{0};
+  std::atomic<int> count_{0};
+  std::atomic<int> suppressed_{0};
+};
+
+// Queues the line for the logging thread and returns, it never waits.
+// Lines are dropped while the queue is full, the logging thread reports
+// how many.
+void LogMessage(LogLevel level, std::string message, int suppressed);
+
+}  // namespace gpupixel
+
 // clang-format off
-#define LOG_TRACE(...)                                                                \
+#define GPUPIXEL_LOG(level, ...)                                                      \
   do {                                                                                \
+    static gpupixel::LogSite gpupixel_log_site;                                       \
+    int gpupixel_suppressed = 0;                                                      \
+    if (gpupixel_log_site.Allow(gpupixel_suppressed)) {                               \
+      gpupixel::LogMessage(level, gpupixel_format(__VA_ARGS__), gpupixel_suppressed); \
+    }                                                                                 \
   } while (0)
 
-#define LOG_DEBUG(...)                                                                \
+#define GPUPIXEL_LOG_STRIPPED(...)                                                    \
   do {                                                                                \
-    std::cout << "[GPUPixel][ DEBUG ] " << gpupixel_format(__VA_ARGS__) << std::endl; \
   } while (0)
 
-#define LOG_INFO(...)                                                                 \
-  do {                                                                                \
-    std::cout << "[GPUPixel][ INFO  ] " << gpupixel_format(__VA_ARGS__) << std::endl; \
-  } while (0)
+#if GPUPIXEL_LOG_LEVEL <= 0
+#define LOG_TRACE(...) GPUPIXEL_LOG(gpupixel::LogLevel::Trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) GPUPIXEL_LOG_STRIPPED(__VA_ARGS__)
+#endif
 
-#define LOG_WARN(...)                                                                 \
-  do {                                                                                \
-    std::cout << "[GPUPixel][ WARN  ] " << gpupixel_format(__VA_ARGS__) << std::endl; \
-  } while (0)
+#if GPUPIXEL_LOG_LEVEL <= 1
+#define LOG_DEBUG(...) GPUPIXEL_LOG(gpupixel::LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) GPUPIXEL_LOG_STRIPPED(__VA_ARGS__)
+#endif
 
-#define LOG_ERROR(...)                                                                \
-  do {                                                                                \
-    std::cout << "[GPUPixel][ERROR  ] " << gpupixel_format(__VA_ARGS__) << std::endl; \
-  } while (0)
+#if GPUPIXEL_LOG_LEVEL <= 2
+#define LOG_INFO(...) GPUPIXEL_LOG(gpupixel::LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) GPUPIXEL_LOG_STRIPPED(__VA_ARGS__)
+#endif
 
-#define LOG_CRITICAL(...)                                                             \
-  do {                                                                                \
-    std::cout << "[GPUPixel][ CRIT ] " << gpupixel_format(__VA_ARGS__) << std::endl;  \
-  } while (0)
+#if GPUPIXEL_LOG_LEVEL <= 3
+#define LOG_WARN(...) GPUPIXEL_LOG(gpupixel::LogLevel::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) GPUPIXEL_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if GPUPIXEL_LOG_LEVEL <= 4
+#define LOG_ERROR(...) GPUPIXEL_LOG(gpupixel::LogLevel::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) GPUPIXEL_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if GPUPIXEL_LOG_LEVEL <= 5
+#define LOG_CRITICAL(...) GPUPIXEL_LOG(gpupixel::LogLevel::Critical, __VA_ARGS__)
+#else
+#define LOG_CRITICAL(...) GPUPIXEL_LOG_STRIPPED(__VA_ARGS__)
+#endif
 // clang-format on
 #endif
@@ -0,0 +1,199 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/utils/quality_governor.h"
+#include <algorithm>
+#include "gpupixel/filter/filter.h"
+#include "utils/logging.h"
+
+namespace gpupixel {
+
+QualityLevel::QualityLevel(const std::string& name) : name_(name) {}
+
+QualityLevel& QualityLevel::SetFramebufferScale(std::shared_ptr<Source> source,
+                                                float scale) {
+  std::weak_ptr<Source> weak_source = source;
+  actions_.push_back([weak_source, scale] {
+    if (auto source = weak_source.lock()) {
+      source->SetFramebufferScale(scale);
+    }
+  });
+  return *this;
+}
+
+QualityLevel& QualityLevel::SetProperty(std::shared_ptr<Filter> filter,
+                                        const std::string& property,
+                                        float value) {
+  std::weak_ptr<Filter> weak_filter = filter;
+  actions_.push_back([weak_filter, property, value] {
+    if (auto filter = weak_filter.lock()) {
+      filter->SetProperty(property, value);
+    }
+  });
+  return *this;
+}
+
+QualityLevel& QualityLevel::SetProperty(std::shared_ptr<Filter> filter,
+                                        const std::string& property,
+                                        int value) {
+  std::weak_ptr<Filter> weak_filter = filter;
+  actions_.push_back([weak_filter, property, value] {
+    if (auto filter = weak_filter.lock()) {
+      filter->SetProperty(property, value);
+    }
+  });
+  return *this;
+}
+
+QualityLevel& QualityLevel::Run(std::function<void()> action) {
+  actions_.push_back(action);
+  return *this;
+}
+
+void QualityLevel::Apply() const {
+  for (auto& action : actions_) {
+    action();
+  }
+}
+
+std::shared_ptr<QualityGovernor> QualityGovernor::Create() {
+  return Create(Options());
+}
+
+std::shared_ptr<QualityGovernor> QualityGovernor::Create(
+    const Options& options) {
+  return std::shared_ptr<QualityGovernor>(new QualityGovernor(options));
+}
+
+QualityGovernor::QualityGovernor(const Options& options) : options_(options) {
+  options_.window_frames = std::max(options_.window_frames, 1);
+}
+
+QualityGovernor::~QualityGovernor() {}
+
+void QualityGovernor::AddLevel(const QualityLevel& level) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  levels_.push_back(level);
+}
+
+void QualityGovernor::SetLevelChangedCallback(LevelChangedCallback callback) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  callback_ = callback;
+}
+
+void QualityGovernor::BeginFrame() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  frame_start_ = std::chrono::steady_clock::now();
+}
+
+void QualityGovernor::EndFrame() {
+  std::chrono::steady_clock::time_point frame_start;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    frame_start = frame_start_;
+  }
+  ReportFrameTime(std::chrono::duration<float, std::milli>(
+                      std::chrono::steady_clock::now() - frame_start)
+                      .count());
+}
+
+void QualityGovernor::ReportFrameTime(float frame_ms) {
+  // Held from the decision until its settings are applied, so that two
+  // threads ending frames can't apply their levels in the opposite order
+  std::unique_lock<std::mutex> apply_lock(apply_mutex_);
+  int level;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    level = Evaluate(frame_ms);
+  }
+  if (level >= 0) {
+    ApplyLevel(level);
+  }
+}
+
+int QualityGovernor::Evaluate(float frame_ms) {
+  if ((int)window_.size() < options_.window_frames) {
+    window_.push_back(frame_ms);
+  } else {
+    window_sum_ -= window_[window_index_];
+    window_[window_index_] = frame_ms;
+  }
+  window_index_ = (window_index_ + 1) % options_.window_frames;
+  window_sum_ += frame_ms;
+  frames_since_change_++;
+
+  if ((int)window_.size() < options_.window_frames) {
+    return -1;
+  }
+  float average = window_sum_ / window_.size();
+  if (average > options_.target_frame_ms * options_.degrade_ratio &&
+      level_ + 1 < (int)levels_.size() &&
+      frames_since_change_ >= options_.degrade_hold_frames) {
+    return level_ + 1;
+  }
+  if (average < options_.target_frame_ms * options_.upgrade_ratio &&
+      level_ > 0 && frames_since_change_ >= options_.upgrade_hold_frames) {
+    return level_ - 1;
+  }
+  return -1;
+}
+
+void QualityGovernor::SetLevel(int level) {
+  std::unique_lock<std::mutex> apply_lock(apply_mutex_);
+  ApplyLevel(level);
+}
+
+void QualityGovernor::ApplyLevel(int level) {
+  QualityLevel quality_level;
+  LevelChangedCallback callback;
+  float average;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (level < 0 || level >= (int)levels_.size()) {
+      return;
+    }
+    average = window_.empty() ? 0.0f : window_sum_ / window_.size();
+    level_ = level;
+    quality_level = levels_[level];
+    callback = callback_;
+
+    // The old measurements describe the previous level
+    window_.clear();
+    window_index_ = 0;
+    window_sum_ = 0.0f;
+    frames_since_change_ = 0;
+  }
+
+  LOG_INFO("QualityGovernor: level {} ({}) at {:.1f} ms per frame", level,
+           quality_level.GetName(), average);
+  quality_level.Apply();
+  if (callback) {
+    callback(level, quality_level.GetName());
+  }
+}
+
+int QualityGovernor::GetLevel() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return level_;
+}
+
+std::string QualityGovernor::GetLevelName() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return level_ < (int)levels_.size() ? levels_[level_].GetName() : "";
+}
+
+int QualityGovernor::GetLevelCount() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return (int)levels_.size();
+}
+
+float QualityGovernor::GetAverageFrameTime() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return window_.empty() ? 0.0f : window_sum_ / window_.size();
+}
+
+}  // namespace gpupixel